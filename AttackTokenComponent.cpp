@@ -0,0 +1,180 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AttackTokenComponent.h"
+#include "Enemy.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+// Sets default values for this component's properties
+UAttackTokenComponent::UAttackTokenComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	MaxAttackers = 2;
+	TokenLifetime = 6.f;
+	ExpiredTokenCooldown = 4.f;
+	NumSlots = 8;
+	SlotRadius = 250.f;
+}
+
+void UAttackTokenComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	NumSlots = FMath::Clamp(NumSlots, 1, 32);
+	SlotOffsets.Reset(NumSlots);
+	for (int32 i = 0; i < NumSlots; ++i)
+	{
+		const float Angle = 2.f * PI * i / NumSlots;
+		SlotOffsets.Add(FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * SlotRadius);
+	}
+	SlotHolders.Init(nullptr, NumSlots);
+}
+
+void UAttackTokenComponent::ExpireTokens()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	for (auto It = Cooldowns.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid() || It.Value() <= Now)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	Tokens.RemoveAllSwap([this, Now](const FAttackToken& Token)
+	{
+		if (!Token.Holder.IsValid())
+			return true;
+
+		if (Now - Token.GrantTime > TokenLifetime)
+		{
+			Cooldowns.Add(Token.Holder, Now + ExpiredTokenCooldown);
+			return true;
+		}
+		return false;
+	});
+}
+
+bool UAttackTokenComponent::RequestToken(AEnemy* Enemy)
+{
+	ExpireTokens();
+
+	if (HasToken(Enemy))
+		return true;
+
+	if (Tokens.Num() >= MaxAttackers || Cooldowns.Contains(Enemy))
+		return false;
+
+	FAttackToken& Token = Tokens.AddDefaulted_GetRef();
+	Token.Holder = Enemy;
+	Token.GrantTime = GetWorld()->GetTimeSeconds();
+
+	// Attackers don't need a waiting spot
+	ReleaseSlot(Enemy);
+	return true;
+}
+
+bool UAttackTokenComponent::HasToken(const AEnemy* Enemy) const
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	for (const FAttackToken& Token : Tokens)
+	{
+		if (Token.Holder.Get() == Enemy && Now - Token.GrantTime <= TokenLifetime)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UAttackTokenComponent::ReleaseToken(const AEnemy* Enemy)
+{
+	Tokens.RemoveAllSwap([Enemy](const FAttackToken& Token) { return Token.Holder.Get() == Enemy; });
+}
+
+int32 UAttackTokenComponent::GetNumActiveAttackers() const
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	int32 Num = 0;
+	for (const FAttackToken& Token : Tokens)
+	{
+		if (Token.Holder.IsValid() && Now - Token.GrantTime <= TokenLifetime)
+		{
+			++Num;
+		}
+	}
+	return Num;
+}
+
+uint32 UAttackTokenComponent::GetFreeSlotMask() const
+{
+	uint32 Mask = 0;
+	for (int32 i = 0; i < SlotHolders.Num(); ++i)
+	{
+		if (!SlotHolders[i].IsValid())
+		{
+			Mask |= 1u << i;
+		}
+	}
+	return Mask;
+}
+
+int32 UAttackTokenComponent::FindSlot(const AEnemy* Enemy) const
+{
+	return SlotHolders.IndexOfByKey(Enemy);
+}
+
+bool UAttackTokenComponent::ClaimSlot(AEnemy* Enemy, FVector& OutLocation, int32 PreferredSlot)
+{
+	const FVector Center = GetOwner()->GetActorLocation();
+
+	int32 Slot = SlotHolders.IndexOfByKey(Enemy);
+	if (Slot == INDEX_NONE && SlotHolders.IsValidIndex(PreferredSlot) && !SlotHolders[PreferredSlot].IsValid())
+	{
+		Slot = PreferredSlot;
+		SlotHolders[Slot] = Enemy;
+	}
+	else if (Slot == INDEX_NONE)
+	{
+		float BestDistSq = MAX_FLT;
+		for (int32 i = 0; i < SlotHolders.Num(); ++i)
+		{
+			if (SlotHolders[i].IsValid())
+				continue;
+
+			const float DistSq = FVector::DistSquared2D(Center + SlotOffsets[i], Enemy->GetActorLocation());
+			if (DistSq < BestDistSq)
+			{
+				BestDistSq = DistSq;
+				Slot = i;
+			}
+		}
+
+		if (Slot == INDEX_NONE)
+			return false;
+
+		SlotHolders[Slot] = Enemy;
+	}
+
+	OutLocation = Center + SlotOffsets[Slot];
+	return true;
+}
+
+void UAttackTokenComponent::ReleaseSlot(const AEnemy* Enemy)
+{
+	for (TWeakObjectPtr<AEnemy>& Holder : SlotHolders)
+	{
+		if (Holder.Get() == Enemy)
+		{
+			Holder.Reset();
+		}
+	}
+}
+
+void UAttackTokenComponent::Release(const AEnemy* Enemy)
+{
+	ReleaseToken(Enemy);
+	ReleaseSlot(Enemy);
+}
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "AttackTokenComponent.generated.h"
+
+class AEnemy;
+
+/**
+ * Decides which enemies may attack the owner, server only.
+ *
+ * At most MaxAttackers enemies hold a token at a time and only token holders swing. The
+ * rest are handed a slot on a ring around the owner and wait there. Tokens run out after
+ * TokenLifetime so an enemy that never reaches the owner can't starve the others, and
+ * that enemy then has to wait ExpiredTokenCooldown before it may ask again.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class FIRSTPROJECT_20_API UAttackTokenComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:	
+	// Sets default values for this component's properties
+	UAttackTokenComponent();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attack Tokens")
+	int32 MaxAttackers;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attack Tokens")
+	float TokenLifetime;
+
+	/** Seconds an enemy whose token ran out is refused a new one, it waits on a slot meanwhile */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attack Tokens")
+	float ExpiredTokenCooldown;
+
+	/** Waiting slots, evenly spaced around the owner. At most 32 so the free ones fit a mask */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attack Tokens", meta = (ClampMin = 1, ClampMax = 32))
+	int32 NumSlots;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Attack Tokens")
+	float SlotRadius;
+
+	/** True if Enemy holds a token or was just given one */
+	bool RequestToken(AEnemy* Enemy);
+	bool HasToken(const AEnemy* Enemy) const;
+	void ReleaseToken(const AEnemy* Enemy);
+
+	/** Keeps Enemy's slot, or gives it PreferredSlot if free, or else the free one closest to it. False when every slot is taken */
+	bool ClaimSlot(AEnemy* Enemy, FVector& OutLocation, int32 PreferredSlot = INDEX_NONE);
+	void ReleaseSlot(const AEnemy* Enemy);
+
+	/** Tokens that haven't run out and whose holder is still around */
+	int32 GetNumActiveAttackers() const;
+
+	const TArray<FVector>& GetSlotOffsets() const { return SlotOffsets; }
+
+	/** Bit N set when slot N is free */
+	uint32 GetFreeSlotMask() const;
+
+	/** Enemy's slot, INDEX_NONE if it has none */
+	int32 FindSlot(const AEnemy* Enemy) const;
+
+	/** Drop the enemy's token and slot */
+	void Release(const AEnemy* Enemy);
+
+	UFUNCTION(BlueprintCallable, Category = "Attack Tokens")
+	int32 GetNumAttackers() const { return Tokens.Num(); }
+
+protected:
+
+	virtual void BeginPlay() override;
+
+	struct FAttackToken
+	{
+		TWeakObjectPtr<AEnemy> Holder;
+		float GrantTime;
+	};
+
+	TArray<FAttackToken> Tokens;
+
+	/** Holders of expired tokens and the time they may request again */
+	TMap<TWeakObjectPtr<AEnemy>, float> Cooldowns;
+
+	/** Ring offsets from the owner, worked out once in BeginPlay */
+	TArray<FVector> SlotOffsets;
+	TArray<TWeakObjectPtr<AEnemy>> SlotHolders;
+
+	/** Forget tokens that ran out or whose holder is gone, the ones that ran out start a cooldown */
+	void ExpireTokens();
+};
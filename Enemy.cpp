@@ -1,6 +1,7 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Enemy.h"
+#include "FirstProject_20.h"
 #include "Components/SphereComponent.h"
 #include "AIController.h"
 #include "Main.h"
@@ -11,13 +12,33 @@
 #include "Components/SkeletalMeshComponent.h"
 #include "Main.h" 
 #include "Kismet/GameplayStatics.h"
+#include "FirstProjectCosmetics.h"
 #include "Engine/SkeletalMeshSocket.h" 
 #include "Sound/SoundCue.h"
 #include "Animation/AnimInstance.h"
 #include "TimerManager.h"
 #include "Components/CapsuleComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
 #include "MainPlayerController.h"
-
+#include "RandomStreamSubsystem.h"
+#include "HitRewindSubsystem.h"
+#include "HitCueBatcher.h"
+#include "EnemyAIController.h"
+#include "FlowFieldSubsystem.h"
+#include "EnemyAISubsystem.h"
+#include "AttackTokenComponent.h"
+#include "EnemySquad.h"
+#include "VisibilitySubsystem.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy AgroSphere Overlap"), STAT_EnemyAgroOverlap, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Enemy CombatSphere Overlap"), STAT_EnemyCombatSphereOverlap, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Enemy Combat Hit"), STAT_EnemyCombatHit, STATGROUP_FirstProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Overlap Calls"), STAT_EnemyOverlapCalls, STATGROUP_FirstProject);
+
+int32 AEnemy::LiveEnemyCount = 0;
 
 // Sets default values
 AEnemy::AEnemy()
@@ -41,18 +62,73 @@ AEnemy::AEnemy()
 
 	bOverlappingCombatSphere = false;
 
+	bUseFlowField = false;
+	FlowFieldHandoverDistance = 300.f;
+
 	Health = 75.f;
 	MaxHealth = 100.f;
+	HealthPacked = 0;
 	Damage = 10.f;
 
 	AttackMinTime = 0.5f;
 	AttackMaxTime = 0.9f;
+	AttackTimeout = 3.f;
+	FacingInterpSpeed = 8.f;
+
+	AIState = EEnemyAIState::EAS_Idle;
+	StateStartTime = 0.f;
+	RecoverEndTime = 0.f;
+	DesiredYaw = 0.f;
+	bHasDesiredYaw = false;
+	SlotRepathDistance = 100.f;
+	SlotGoal = FVector::ZeroVector;
+	PreferredSlot = INDEX_NONE;
+	CautiousHealthFraction = 0.25f;
+	bPooled = false;
+	bRequireLineOfSight = true;
 
 	EnemyMovementStatus = EEnemyMovementStatus::EMS_Idle;
 
 	DeathDelay = 2.f;
 
 	bHasValidTarget = false;
+	RewindSlot = INDEX_NONE;
+
+	// Crowd following does the avoidance, RVO would fight it
+	AIControllerClass = AEnemyAIController::StaticClass();
+	GetCharacterMovement()->bUseRVOAvoidance = false;
+
+	// Enemies only go where the navmesh goes, so skip the floor sweeps and follow it instead.
+	// The height is re-projected every NavMeshProjectionInterval and eased in between
+	bUseNavWalking = true;
+	DynamicObstacleRadius = 150.f;
+	GetCharacterMovement()->DefaultLandMovementMode = MOVE_NavWalking;
+	GetCharacterMovement()->NavMeshProjectionInterval = 0.2f;
+	GetCharacterMovement()->NavMeshProjectionInterpSpeed = 12.f;
+
+	// Enemies don't block each other, the crowd keeps them apart. They still block the player
+	GetCapsuleComponent()->SetCollisionObjectType(ECC_Enemy);
+	GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_Enemy, ECollisionResponse::ECR_Ignore);
+
+	// Lots of these around, keep their updates cheap
+	NetUpdateFrequency = 10.f;
+	MinNetUpdateFrequency = 2.f;
+	GetReplicatedMovement_Mutable().LocationQuantizationLevel = EVectorQuantization::RoundWholeNumber;
+	GetReplicatedMovement_Mutable().VelocityQuantizationLevel = EVectorQuantization::RoundWholeNumber;
+	GetReplicatedMovement_Mutable().RotationQuantizationLevel = ERotatorQuantization::ByteComponents;
+}
+
+void AEnemy::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Push model: only compared when a setter marked them dirty
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AEnemy, EnemyMovementStatus, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AEnemy, HealthPacked, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AEnemy, bAttacking, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AEnemy, CombatTarget, Params);
 }
 
 // Called when the game starts or when spawned
@@ -60,8 +136,31 @@ void AEnemy::BeginPlay()
 {
 	Super::BeginPlay();
 
+	++LiveEnemyCount;
+	INC_DWORD_STAT(STAT_LiveEnemies);
+
+	SetHealth(Health);
+
+	// bUseNavWalking may have been turned off in the blueprint too
+	UCharacterMovementComponent* Movement = GetCharacterMovement();
+	Movement->DefaultLandMovementMode = bUseNavWalking ? MOVE_NavWalking : MOVE_Walking;
+	if (Movement->IsMovingOnGround() && Movement->MovementMode != Movement->DefaultLandMovementMode)
+	{
+		Movement->SetDefaultMovementMode();
+	}
+
+	if (UHitRewindSubsystem* HitRewind = GetWorld()->GetSubsystem<UHitRewindSubsystem>())
+	{
+		RewindSlot = HitRewind->RegisterTarget(this);
+	}
+
 	AIController = Cast<AAIController>(GetController());
 
+	if (UEnemyAISubsystem* EnemyAI = GetWorld()->GetSubsystem<UEnemyAISubsystem>())
+	{
+		EnemyAI->RegisterEnemy(this);
+	}
+
 	AgroSphere->OnComponentBeginOverlap.AddDynamic(this, &AEnemy::AgroSphereOnOverlapBegin);
 	AgroSphere->OnComponentEndOverlap.AddDynamic(this, &AEnemy::AgroSphereOnOverlapEnd);
 
@@ -81,11 +180,74 @@ void AEnemy::BeginPlay()
 	GetCapsuleComponent()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Camera, ECollisionResponse::ECR_Ignore);
 }
 
+void AEnemy::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// A pooled enemy was taken off the count when it went into the pool
+	if (!bPooled)
+	{
+		--LiveEnemyCount;
+		DEC_DWORD_STAT(STAT_LiveEnemies);
+	}
+
+	UHitRewindSubsystem* HitRewind = GetWorld()->GetSubsystem<UHitRewindSubsystem>();
+	if (HitRewind && RewindSlot != INDEX_NONE)
+	{
+		HitRewind->UnregisterTarget(RewindSlot);
+		RewindSlot = INDEX_NONE;
+	}
+
+	if (UEnemyAISubsystem* EnemyAI = GetWorld()->GetSubsystem<UEnemyAISubsystem>())
+	{
+		EnemyAI->UnregisterEnemy(this);
+	}
+	ReleaseAttackToken();
+
+	if (AEnemySquad* MySquad = Squad.Get())
+	{
+		MySquad->RemoveMember(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 // Called every frame
 void AEnemy::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	if (bHasDesiredYaw)
+	{
+		const FRotator Facing(0.f, DesiredYaw, 0.f);
+		SetActorRotation(FMath::RInterpTo(GetActorRotation(), Facing, DeltaTime, FacingInterpSpeed));
+	}
+
+	if (bUseFlowField && EnemyMovementStatus == EEnemyMovementStatus::EMS_MoveToTarget && !bOverlappingCombatSphere && MoveTarget.IsValid())
+	{
+		FVector Direction;
+		const bool bNearTarget = FVector::DistSquared2D(GetActorLocation(), MoveTarget->GetActorLocation()) < FMath::Square(FlowFieldHandoverDistance);
+		if (!bNearTarget && RequestMoveDirection(Direction))
+		{
+			if (AIController && AIController->GetMoveStatus() != EPathFollowingStatus::Idle)
+			{
+				AIController->StopMovement();
+			}
+			AddMovementInput(Direction);
+		}
+		else if (AIController && AIController->GetMoveStatus() == EPathFollowingStatus::Idle)
+		{
+			// Close in, or off the field: let the path follower finish the approach
+			FAIMoveRequest MoveRequest;
+			MoveRequest.SetGoalActor(MoveTarget.Get());
+			MoveRequest.SetAcceptanceRadius(20.0f);
+			AIController->MoveTo(MoveRequest);
+		}
+	}
+}
+
+bool AEnemy::RequestMoveDirection(FVector& OutDirection) const
+{
+	UFlowFieldSubsystem* FlowField = GetWorld()->GetSubsystem<UFlowFieldSubsystem>();
+	return FlowField && FlowField->SampleDirection(MoveTarget.Get(), GetActorLocation(), OutDirection);
 }
 
 // Called to bind functionality to input
@@ -96,12 +258,15 @@ void AEnemy::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 
 void AEnemy::AgroSphereOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult & SweepResult)
 {
+	SCOPE_CYCLE_COUNTER(STAT_EnemyAgroOverlap);
+	INC_DWORD_STAT(STAT_EnemyOverlapCalls);
+
 	if (OtherActor && Alive())
 	{
 		AMain* Main = Cast<AMain>(OtherActor);
 		if (Main)
 		{
-			MoveToTarget(Main);
+			AgroCandidate = Main;
 		}
 	}
 
@@ -109,6 +274,9 @@ void AEnemy::AgroSphereOnOverlapBegin(UPrimitiveComponent* OverlappedComponent,
 
 void AEnemy::AgroSphereOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
 {
+	SCOPE_CYCLE_COUNTER(STAT_EnemyAgroOverlap);
+	INC_DWORD_STAT(STAT_EnemyOverlapCalls);
+
 	if (OtherActor)
 	{
 		AMain* Main = Cast<AMain>(OtherActor);
@@ -124,11 +292,13 @@ void AEnemy::AgroSphereOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AA
 
 			Main->UpdateCombatTarget();
 
-			SetEnemyMovementStatus(EEnemyMovementStatus::EMS_Idle);
-			
-			if (AIController)
+			if (AgroTarget == Main)
 			{
-				AIController->StopMovement();
+				AgroTarget.Reset();
+			}
+			if (AgroCandidate == Main)
+			{
+				AgroCandidate.Reset();
 			}
 		}
 	}
@@ -136,6 +306,9 @@ void AEnemy::AgroSphereOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AA
 
 void AEnemy::CombatSphereOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult & SweepResult)
 {
+	SCOPE_CYCLE_COUNTER(STAT_EnemyCombatSphereOverlap);
+	INC_DWORD_STAT(STAT_EnemyOverlapCalls);
+
 	if (OtherActor && Alive())
 	{
 		AMain* Main = Cast<AMain>(OtherActor);
@@ -154,18 +327,17 @@ void AEnemy::CombatSphereOnOverlapBegin(UPrimitiveComponent* OverlappedComponent
 				Main->MainPlayerController->DisplayEnemyHealthBar();
 			}
 
-			CombatTarget = Main;
+			SetCombatTarget(Main);
 			bOverlappingCombatSphere = true;
-			//SetEnemyMovementStatus(EEnemyMovementStatus::EMS_Attacking);
-			
-			float AttackTime = FMath::FRandRange(AttackMinTime, AttackMaxTime);
-			GetWorldTimerManager().SetTimer(AttackTimer, this, &AEnemy::Attack, AttackTime);
 		}
 	}
 }
 
 void AEnemy::CombatSphereOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
 {
+	SCOPE_CYCLE_COUNTER(STAT_EnemyCombatSphereOverlap);
+	INC_DWORD_STAT(STAT_EnemyOverlapCalls);
+
 	if (OtherActor && OtherComp)
 	{
 		AMain* Main = Cast<AMain>(OtherActor);
@@ -173,8 +345,7 @@ void AEnemy::CombatSphereOnOverlapEnd(UPrimitiveComponent* OverlappedComponent,
 		if (Main)
 		{		
 			bOverlappingCombatSphere = false;
-			MoveToTarget(Main);
-			CombatTarget = nullptr;		
+			SetCombatTarget(nullptr);
 
 			if (Main->CombatTarget == this)
 			{
@@ -188,14 +359,6 @@ void AEnemy::CombatSphereOnOverlapEnd(UPrimitiveComponent* OverlappedComponent,
 				if (MainMesh)
 					Main->MainPlayerController->RemoveEnemyHealthBar();
 			}
-
-			GetWorldTimerManager().ClearTimer(AttackTimer);
-			/*
-			SetEnemyMovementStatus(EEnemyMovementStatus::EMS_MoveToTarget);
-
-			if(bOverlappingCombatSphere == false)
-			MoveToTarget(Main);
-			*/	
 		}
 	}
 }
@@ -203,6 +366,17 @@ void AEnemy::CombatSphereOnOverlapEnd(UPrimitiveComponent* OverlappedComponent,
 void AEnemy::MoveToTarget(AMain* Target)
 {
 	SetEnemyMovementStatus(EEnemyMovementStatus::EMS_MoveToTarget);
+	MoveTarget = Target;
+
+	if (bUseFlowField)
+	{
+		// Tick steers along the field and only falls back to MoveTo near the target
+		if (AIController)
+		{
+			AIController->StopMovement();
+		}
+		return;
+	}
 
 	if (AIController)
 	{
@@ -231,28 +405,21 @@ void AEnemy::MoveToTarget(AMain* Target)
 
 void AEnemy::CombatOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult & SweepResult)
 {
+	SCOPE_CYCLE_COUNTER(STAT_EnemyCombatHit);
+	INC_DWORD_STAT(STAT_EnemyOverlapCalls);
+
 	if (OtherActor)
 	{
 		AMain* Main = Cast<AMain>(OtherActor);
 
-		if (Main)
+		// Enemies only fight on the server, clients get the hit through the batcher
+		if (Main && HasAuthority())
 		{
-			if (Main->HitParticles)
-			{
-				const USkeletalMeshSocket* TipSocket = GetMesh()->GetSocketByName("TipSocket");
-
-				if (TipSocket)
-				{
-					FVector SocketLocation = TipSocket->GetSocketLocation(GetMesh());
-					UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), Main->HitParticles, SocketLocation, FRotator(0.f), false);
-				}
-				//UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), Enemy->HitParticles, GetActorLocation(), FRotator(0.f), false);
-			}
+			const USkeletalMeshSocket* TipSocket = GetMesh()->GetSocketByName("TipSocket");
+			FVector SocketLocation = TipSocket ? TipSocket->GetSocketLocation(GetMesh()) : GetActorLocation();
+			EPhysicalSurface Surface = UPhysicalMaterial::DetermineSurfaceType(Main->GetMesh()->BodyInstance.GetSimplePhysicalMaterial());
+			AHitCueBatcher::QueueHitCue(this, TipSocket ? Main->HitParticles : nullptr, Main->HitSound, SocketLocation, Surface);
 
-			if (Main->HitSound)
-			{
-				UGameplayStatics::PlaySound2D(this, Main->HitSound);
-			}
 			if (DamageTypeClass)
 			{
 				UGameplayStatics::ApplyDamage(Main, Damage, AIController, this, DamageTypeClass);
@@ -272,7 +439,7 @@ void AEnemy::ActivateCollision()
 
 	if (SwingSound)
 	{
-		UGameplayStatics::PlaySound2D(this, SwingSound);
+		FFirstProjectCosmetics::PlaySound2D(this, SwingSound);
 	}
 }
 
@@ -283,17 +450,18 @@ void AEnemy::DeactivateCollision()
 
 void AEnemy::Attack()
 {
-	if (Alive() && bHasValidTarget)
+	// Think only gets here with the target in reach, see DecideThink
+	if (Alive() && AgroTarget.IsValid())
 	{
 		if (AIController)
 		{
 			AIController->StopMovement();
-			SetEnemyMovementStatus(EEnemyMovementStatus::EMS_Attacking);
 		}
+		SetEnemyMovementStatus(EEnemyMovementStatus::EMS_Attacking);
 
 		if (!bAttacking)
 		{
-			bAttacking = true;
+			SetAttacking(true);
 			UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
 
 			if (AnimInstance)
@@ -305,27 +473,403 @@ void AEnemy::Attack()
 	}
 }
 
+// CombatMontage -> Notify(EndAttacking) -> Enemy anim BP. Think moves on to Recover
 void AEnemy::AttackEnd()
 {
-	bAttacking = false;
-	
-	if (bOverlappingCombatSphere)
+	SetAttacking(false);
+}
+
+void AEnemy::Think(float Now)
+{
+	FEnemyThinkInput Input;
+	FEnemyThinkIntent Intent;
+	UpdatePerception();
+	GatherThinkInput(Now, Input);
+	DecideThink(Input, Intent);
+	ApplyThinkIntent(Intent, Now);
+}
+
+void AEnemy::UpdatePerception()
+{
+	AMain* Candidate = AgroCandidate.Get();
+
+	// Once aggroed we keep chasing around corners, until the player leaves the agro sphere
+	if (Candidate == nullptr || AgroTarget.IsValid())
+		return;
+
+	UVisibilitySubsystem* Visibility = GetWorld()->GetSubsystem<UVisibilitySubsystem>();
+	if (!bRequireLineOfSight || Visibility == nullptr || Visibility->GetLineOfSight(this, Candidate) == ELineOfSight::Visible)
 	{
-		float AttackTime = FMath::FRandRange(AttackMinTime, AttackMaxTime);
-		GetWorldTimerManager().SetTimer(AttackTimer, this, &AEnemy::Attack, AttackTime);
+		AgroTarget = Candidate;
+	}
+}
+
+void AEnemy::GatherThinkInput(float Now, FEnemyThinkInput& Out) const
+{
+	const AMain* Target = AgroTarget.Get();
+
+	Out.State = AIState;
+	Out.Now = Now;
+	Out.StateStartTime = StateStartTime;
+	Out.RecoverEndTime = RecoverEndTime;
+	Out.AttackTimeout = AttackTimeout;
+	Out.Location = GetActorLocation();
+	Out.TargetLocation = Target ? Target->GetActorLocation() : Out.Location;
+	Out.bHasTarget = Target != nullptr;
+	Out.bTargetAlive = Target && Target->MovementStatus != EMovementStatus::EMS_Dead;
+	Out.bAttacking = bAttacking;
+	Out.bPathFollowingIdle = !bUseFlowField && AIController && AIController->GetMoveStatus() == EPathFollowingStatus::Idle;
+
+	// Raw numbers only, the range and scoring work happens in DecideThink
+	Out.CombatReach = CombatSphere->GetScaledSphereRadius() + (Target ? Target->GetCapsuleComponent()->GetScaledCapsuleRadius() : 0.f);
+	Out.HealthFraction = MaxHealth > 0.f ? Health / MaxHealth : 1.f;
+	Out.CautiousHealthFraction = CautiousHealthFraction;
+
+	const UAttackTokenComponent* Tokens = Target ? Target->AttackTokens : nullptr;
+	Out.bHoldsToken = Tokens && Tokens->HasToken(this);
+	Out.TargetAttackers = Tokens ? Tokens->GetNumActiveAttackers() : 0;
+	Out.MaxAttackers = Tokens ? Tokens->MaxAttackers : MAX_int32;
+	Out.SlotCenter = Out.TargetLocation;
+	Out.SlotOffsets = Tokens ? Tokens->GetSlotOffsets().GetData() : nullptr;
+	Out.NumSlots = Tokens ? Tokens->GetSlotOffsets().Num() : 0;
+	Out.FreeSlotMask = Tokens ? Tokens->GetFreeSlotMask() : 0;
+	Out.HeldSlot = Tokens ? Tokens->FindSlot(this) : INDEX_NONE;
+}
+
+void AEnemy::DecideThink(const FEnemyThinkInput& In, FEnemyThinkIntent& Out)
+{
+	Out.StateWithToken = In.State;
+	Out.StateWithoutToken = In.State;
+	Out.bNeedsToken = false;
+	Out.bReleaseToken = false;
+	Out.StayAction = EEnemyThinkAction::None;
+	Out.bHasTarget = In.bHasTarget;
+	Out.TargetYaw = (In.TargetLocation - In.Location).Rotation().Yaw;
+	Out.PreferredSlot = In.HeldSlot;
+
+	auto Transition = [&Out](EEnemyAIState NewState)
+	{
+		Out.StateWithToken = NewState;
+		Out.StateWithoutToken = NewState;
+	};
+
+	const bool bInCombatRange = In.bHasTarget && FVector::DistSquared2D(In.Location, In.TargetLocation) <= FMath::Square(In.CombatReach);
+	const bool bCanHitTarget = bInCombatRange && In.bTargetAlive;
+
+	// Only queue up for a token that could be handed out. Badly hurt enemies hang back
+	// while someone else is already on the target
+	const bool bHoldBack = In.HealthFraction < In.CautiousHealthFraction && In.TargetAttackers > 0;
+	const bool bTokenWorthAsking = In.bHoldsToken || (In.TargetAttackers < In.MaxAttackers && !bHoldBack);
+	auto TokenTransition = [&Out, bTokenWorthAsking](EEnemyAIState WithToken, EEnemyAIState WithoutToken)
+	{
+		Out.bNeedsToken = bTokenWorthAsking;
+		Out.StateWithToken = bTokenWorthAsking ? WithToken : WithoutToken;
+		Out.StateWithoutToken = WithoutToken;
+	};
+
+	// Score the free slots for whoever may end up waiting: closest first, but walking
+	// across the target's front to get there counts double
+	if (In.bHasTarget && In.HeldSlot == INDEX_NONE && In.SlotOffsets)
+	{
+		float BestScore = MAX_FLT;
+		for (int32 Slot = 0; Slot < In.NumSlots; ++Slot)
+		{
+			if ((In.FreeSlotMask & (1u << Slot)) == 0)
+				continue;
+
+			const FVector SlotLocation = In.SlotCenter + In.SlotOffsets[Slot];
+			float Score = FVector::Dist2D(In.Location, SlotLocation);
+			if (FMath::PointDistToSegment(In.SlotCenter, In.Location, SlotLocation) < In.SlotOffsets[Slot].Size2D() * 0.5f)
+			{
+				Score *= 2.f;
+			}
+			if (Score < BestScore)
+			{
+				BestScore = Score;
+				Out.PreferredSlot = Slot;
+			}
+		}
+	}
+
+	switch (In.State)
+	{
+	case EEnemyAIState::EAS_Idle:
+		if (In.bHasTarget)
+		{
+			Transition(EEnemyAIState::EAS_Chase);
+		}
+		break;
+
+	case EEnemyAIState::EAS_Chase:
+		if (!In.bHasTarget)
+		{
+			Transition(EEnemyAIState::EAS_Idle);
+		}
+		else
+		{
+			// Wind up before the first swing. Without a token, wait on the ring
+			TokenTransition(bInCombatRange ? EEnemyAIState::EAS_Recover : EEnemyAIState::EAS_Chase, EEnemyAIState::EAS_Surround);
+
+			// The path follower finished or gave up, ask again
+			Out.StayAction = In.bPathFollowingIdle ? EEnemyThinkAction::RepathToTarget : EEnemyThinkAction::None;
+		}
+		break;
+
+	case EEnemyAIState::EAS_Attack:
+		if (!In.bAttacking || In.Now - In.StateStartTime > In.AttackTimeout)
+		{
+			// One swing per token, then someone else gets a turn
+			Out.bReleaseToken = true;
+			Transition(EEnemyAIState::EAS_Recover);
+		}
+		break;
+
+	case EEnemyAIState::EAS_Surround:
+		if (!In.bHasTarget)
+		{
+			Transition(EEnemyAIState::EAS_Idle);
+		}
+		else
+		{
+			TokenTransition(EEnemyAIState::EAS_Chase, EEnemyAIState::EAS_Surround);
+			Out.StayAction = EEnemyThinkAction::FollowSlot;
+		}
+		break;
+
+	case EEnemyAIState::EAS_Recover:
+		if (In.Now >= In.RecoverEndTime)
+		{
+			if (!In.bHasTarget)
+			{
+				Transition(EEnemyAIState::EAS_Idle);
+			}
+			else
+			{
+				TokenTransition(bCanHitTarget ? EEnemyAIState::EAS_Attack : EEnemyAIState::EAS_Chase, EEnemyAIState::EAS_Surround);
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+void AEnemy::ApplyThinkIntent(const FEnemyThinkIntent& Intent, float Now)
+{
+	AMain* Target = AgroTarget.Get();
+
+	if (Intent.bReleaseToken)
+	{
+		SetAttacking(false);
+		ReleaseAttackToken();
+	}
+
+	PreferredSlot = Intent.PreferredSlot;
+
+	// Tokens are shared between enemies, so only the game thread hands them out
+	EEnemyAIState NewState = Intent.StateWithToken;
+	if (Intent.bNeedsToken && !RequestAttackToken(Target))
+	{
+		NewState = Intent.StateWithoutToken;
+	}
+
+	if (NewState != AIState)
+	{
+		SetAIState(NewState, Now);
+	}
+	else if (Intent.StayAction == EEnemyThinkAction::RepathToTarget && Target)
+	{
+		MoveToTarget(Target);
+	}
+	else if (Intent.StayAction == EEnemyThinkAction::FollowSlot)
+	{
+		MoveToSlot(Target, false);
+	}
+
+	UpdateGroundMovementMode();
+
+	bHasDesiredYaw = Intent.bHasTarget && (AIState == EEnemyAIState::EAS_Attack || AIState == EEnemyAIState::EAS_Recover || AIState == EEnemyAIState::EAS_Surround);
+	DesiredYaw = Intent.TargetYaw;
+}
+
+void AEnemy::OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PrevMovementMode, PreviousCustomMode);
+
+	// The movement component sets WorldStatic and WorldDynamic to ignore for nav walking. Overlap
+	// is enough to get weapon hits and item volumes back without sweeping against geometry
+	if (GetCharacterMovement()->MovementMode == MOVE_NavWalking)
+	{
+		GetCapsuleComponent()->SetCollisionResponseToChannel(ECC_WorldDynamic, ECollisionResponse::ECR_Overlap);
+	}
+}
+
+void AEnemy::UpdateGroundMovementMode()
+{
+	UCharacterMovementComponent* Movement = GetCharacterMovement();
+
+	// Knocked into the air: lands in walking mode and comes back here next think
+	if (!bUseNavWalking || !Movement->IsMovingOnGround())
+		return;
+
+	const bool bNearObstacle = IsNearDynamicObstacle();
+	if (bNearObstacle && Movement->MovementMode == MOVE_NavWalking)
+	{
+		Movement->SetMovementMode(MOVE_Walking);
+	}
+	else if (!bNearObstacle && Movement->MovementMode == MOVE_Walking)
+	{
+		Movement->SetMovementMode(MOVE_NavWalking);
+	}
+}
+
+bool AEnemy::IsNearDynamicObstacle() const
+{
+	FCollisionObjectQueryParams ObjectParams;
+	ObjectParams.AddObjectTypesToQuery(ECC_WorldStatic);
+	ObjectParams.AddObjectTypesToQuery(ECC_WorldDynamic);
+	ObjectParams.AddObjectTypesToQuery(ECC_PhysicsBody);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(EnemyObstacleCheck), false, this);
+
+	TArray<FOverlapResult> Overlaps;
+	const float HalfHeight = GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	const FCollisionShape Shape = FCollisionShape::MakeCapsule(DynamicObstacleRadius, HalfHeight);
+	GetWorld()->OverlapMultiByObjectType(Overlaps, GetActorLocation(), FQuat::Identity, ObjectParams, Shape, QueryParams);
+
+	// The navmesh already accounts for anything that doesn't move
+	for (const FOverlapResult& Overlap : Overlaps)
+	{
+		const UPrimitiveComponent* Component = Overlap.GetComponent();
+		if (Component && Component->Mobility == EComponentMobility::Movable && Component->GetCollisionResponseToChannel(ECC_Pawn) == ECR_Block)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void AEnemy::SetAIState(EEnemyAIState NewState, float Now)
+{
+	if (AIState == NewState)
+		return;
+
+	AIState = NewState;
+	StateStartTime = Now;
+
+	switch (NewState)
+	{
+	case EEnemyAIState::EAS_Idle:
+		SetEnemyMovementStatus(EEnemyMovementStatus::EMS_Idle);
+		ReleaseAttackToken();
+		MoveTarget.Reset();
+		if (AIController)
+		{
+			AIController->StopMovement();
+		}
+		break;
+
+	case EEnemyAIState::EAS_Chase:
+		MoveToTarget(AgroTarget.Get());
+		break;
+
+	case EEnemyAIState::EAS_Attack:
+		Attack();
+		break;
+
+	case EEnemyAIState::EAS_Recover:
+		RecoverEndTime = Now + URandomStreamSubsystem::Get(this, ERandomStreamId::ERS_AI).FRandRange(AttackMinTime, AttackMaxTime);
+		break;
+
+	case EEnemyAIState::EAS_Surround:
+		// Stop chasing the player itself, flow field steering included
+		SetEnemyMovementStatus(EEnemyMovementStatus::EMS_MoveToTarget);
+		MoveTarget.Reset();
+		MoveToSlot(AgroTarget.Get(), true);
+		break;
+
+	default:
+		break;
+	}
+}
+
+bool AEnemy::RequestAttackToken(AMain* Target)
+{
+	UAttackTokenComponent* Tokens = Target ? Target->AttackTokens : nullptr;
+	if (Tokens == nullptr)
+		return true;
+
+	if (AttackTokenSource.Get() != Tokens)
+	{
+		ReleaseAttackToken();
+		AttackTokenSource = Tokens;
+	}
+	return Tokens->RequestToken(this);
+}
+
+void AEnemy::ReleaseAttackToken()
+{
+	if (UAttackTokenComponent* Tokens = AttackTokenSource.Get())
+	{
+		Tokens->Release(this);
+	}
+	AttackTokenSource.Reset();
+}
+
+void AEnemy::MoveToSlot(AMain* Target, bool bForce)
+{
+	if (Target == nullptr || Target->AttackTokens == nullptr)
+		return;
+
+	// Without a controller our squad reads SlotGoal and does the walking
+	FVector SlotLocation;
+	if (!Target->AttackTokens->ClaimSlot(this, SlotLocation, PreferredSlot))
+	{
+		// Ring is full, hold position until a slot or a token frees up
+		if (bForce)
+		{
+			SlotGoal = GetActorLocation();
+			if (AIController)
+			{
+				AIController->StopMovement();
+			}
+		}
+		return;
+	}
+
+	if (bForce || FVector::DistSquared2D(SlotLocation, SlotGoal) > FMath::Square(SlotRepathDistance))
+	{
+		SlotGoal = SlotLocation;
+		if (AIController)
+		{
+			AIController->MoveToLocation(SlotLocation, 20.f, true, true, true);
+		}
+	}
+}
+
+void AEnemy::RequestSquadMove(const FVector& Direction)
+{
+	if (!bPooled && Alive())
+	{
+		AddMovementInput(Direction);
 	}
 }
 
 float AEnemy::TakeDamage(float DamageAmount, struct FDamageEvent const & DamageEvent, class AController * EventInstigator, AActor * DamageCauser)
 {
+	INC_DWORD_STAT(STAT_DamageEvents);
+	CSV_CUSTOM_STAT(FirstProject, DamageEvents, 1, ECsvCustomStatOp::Accumulate);
+	FIRSTPROJECT_TRACE(Damage, this, DamageCauser, DamageAmount);
+
 	if (Health - DamageAmount <= 0.f)
 	{
-		Health = 0.f;
+		SetHealth(0.f);
 		Die(DamageCauser);
 	}
 	else
 	{
-		Health -= DamageAmount;
+		SetHealth(Health - DamageAmount);
 	}
 
 	return DamageAmount;
@@ -334,7 +878,18 @@ float AEnemy::TakeDamage(float DamageAmount, struct FDamageEvent const & DamageE
 // Causer : What killed this enemy object
 void AEnemy::Die(AActor* Causer)
 {
+	FIRSTPROJECT_TRACE(Death, this);
+
 	SetEnemyMovementStatus(EEnemyMovementStatus::EMS_Dead);
+	SetAIState(EEnemyAIState::EAS_Dead, GetWorld()->GetTimeSeconds());
+	bHasDesiredYaw = false;
+	ReleaseAttackToken();
+
+	if (UEnemyAISubsystem* EnemyAI = GetWorld()->GetSubsystem<UEnemyAISubsystem>())
+	{
+		EnemyAI->UnregisterEnemy(this);
+	}
+
 	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
 
 	if (AnimInstance)
@@ -348,7 +903,7 @@ void AEnemy::Die(AActor* Causer)
 	CombatSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 
-	bAttacking = false;
+	SetAttacking(false);
 
 	AMain* Main = Cast<AMain>(Causer);
 	if (Main)
@@ -365,11 +920,120 @@ void AEnemy::DeathEnd()
 	GetWorldTimerManager().SetTimer(DeathTimer, this, &AEnemy::Disappear, DeathDelay);
 }
 
+void AEnemy::SetEnemyMovementStatus(EEnemyMovementStatus Status)
+{
+	if (Status != EnemyMovementStatus)
+	{
+		FIRSTPROJECT_TRACE(EnemyState, this, (uint8)Status);
+		MARK_PROPERTY_DIRTY_FROM_NAME(AEnemy, EnemyMovementStatus, this);
+	}
+	EnemyMovementStatus = Status;
+}
+
+void AEnemy::SetHealth(float NewHealth)
+{
+	Health = NewHealth;
+
+	uint8 NewPacked = MaxHealth > 0.f ? (uint8)FMath::RoundToInt(FMath::Clamp(Health / MaxHealth, 0.f, 1.f) * 255.f) : 0;
+	if (NewPacked != HealthPacked)
+	{
+		HealthPacked = NewPacked;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AEnemy, HealthPacked, this);
+	}
+}
+
+void AEnemy::OnRep_HealthPacked()
+{
+	Health = (HealthPacked / 255.f) * MaxHealth;
+}
+
+void AEnemy::SetAttacking(bool bNewAttacking)
+{
+	if (bAttacking != bNewAttacking)
+	{
+		bAttacking = bNewAttacking;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AEnemy, bAttacking, this);
+	}
+}
+
+void AEnemy::SetCombatTarget(AMain* Target)
+{
+	if (CombatTarget != Target)
+	{
+		CombatTarget = Target;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AEnemy, CombatTarget, this);
+	}
+}
+
 bool AEnemy::Alive()
 {
 	return GetEnemyMovementStatus() != EEnemyMovementStatus::EMS_Dead;
 }
 
+void AEnemy::SetPooled(bool bNewPooled)
+{
+	if (bNewPooled != bPooled)
+	{
+		if (bNewPooled)
+		{
+			--LiveEnemyCount;
+			DEC_DWORD_STAT(STAT_LiveEnemies);
+		}
+		else
+		{
+			++LiveEnemyCount;
+			INC_DWORD_STAT(STAT_LiveEnemies);
+		}
+	}
+	bPooled = bNewPooled;
+
+	// Collision off also ends the sphere overlaps, which drops the agro and combat targets
+	SetActorHiddenInGame(bNewPooled);
+	SetActorEnableCollision(!bNewPooled);
+	SetActorTickEnabled(!bNewPooled);
+	GetCharacterMovement()->SetComponentTickEnabled(!bNewPooled);
+
+	// The controller keeps ticking and the crowd keeps simulating its agent otherwise
+	UCrowdFollowingComponent* CrowdFollowing = AIController ? Cast<UCrowdFollowingComponent>(AIController->GetPathFollowingComponent()) : nullptr;
+	if (AIController)
+	{
+		if (bNewPooled)
+		{
+			AIController->StopMovement();
+		}
+		AIController->SetActorTickEnabled(!bNewPooled);
+		AIController->GetPathFollowingComponent()->SetComponentTickEnabled(!bNewPooled);
+	}
+	if (CrowdFollowing)
+	{
+		CrowdFollowing->SetCrowdSimulationState(bNewPooled ? ECrowdSimulationState::Disabled : ECrowdSimulationState::Enabled);
+	}
+
+	UEnemyAISubsystem* EnemyAI = GetWorld()->GetSubsystem<UEnemyAISubsystem>();
+	if (bNewPooled)
+	{
+		SetAIState(EEnemyAIState::EAS_Idle, GetWorld()->GetTimeSeconds());
+		AgroTarget.Reset();
+		AgroCandidate.Reset();
+		bHasDesiredYaw = false;
+		if (EnemyAI)
+		{
+			EnemyAI->UnregisterEnemy(this);
+		}
+
+		// Goes dormant once clients have seen it hidden
+		SetNetDormancy(DORM_DormantAll);
+	}
+	else
+	{
+		SetNetDormancy(DORM_Awake);
+		if (EnemyAI)
+		{
+			EnemyAI->RegisterEnemy(this);
+		}
+	}
+}
+
 void AEnemy::Disappear()
 {
 	Destroy();
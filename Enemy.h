@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "FirstProjectTrace.h"
 #include "Enemy.generated.h"
 
 UENUM(BlueprintType)
@@ -18,6 +19,77 @@ enum class EEnemyMovementStatus :uint8
 	EMS_MAX				UMETA(DeplayName = "DefaultMAX")
 };
 
+/** What AEnemy::Think is doing, server only. EnemyMovementStatus is the replicated view of it */
+UENUM(BlueprintType)
+enum class EEnemyAIState : uint8
+{
+	EAS_Idle			UMETA(DisplayName = "Idle"),
+	EAS_Chase			UMETA(DisplayName = "Chase"),
+	EAS_Attack			UMETA(DisplayName = "Attack"),
+	EAS_Recover			UMETA(DisplayName = "Recover"),
+	EAS_Surround		UMETA(DisplayName = "Surround"),
+	EAS_Dead			UMETA(DisplayName = "Dead"),
+
+	EAS_MAX				UMETA(DisplayName = "DefaultMAX")
+};
+
+/** What an enemy does if its state doesn't change this think */
+enum class EEnemyThinkAction : uint8
+{
+	None,
+	RepathToTarget,
+	FollowSlot
+};
+
+/** Copy of what AEnemy::DecideThink looks at, taken on the game thread */
+struct FEnemyThinkInput
+{
+	EEnemyAIState State;
+	float Now;
+	float StateStartTime;
+	float RecoverEndTime;
+	float AttackTimeout;
+	FVector Location;
+	FVector TargetLocation;
+	bool bHasTarget;
+	bool bTargetAlive;
+	bool bAttacking;
+	bool bPathFollowingIdle;
+
+	/** Our combat sphere plus the target's capsule, how close we have to be for a swing to land */
+	float CombatReach;
+	float HealthFraction;
+	float CautiousHealthFraction;
+
+	/** Tokens still running on the target, out of how many it hands out */
+	bool bHoldsToken;
+	int32 TargetAttackers;
+	int32 MaxAttackers;
+
+	/** The target's surround ring. The offsets belong to its token component, which only sets them in BeginPlay */
+	FVector SlotCenter;
+	const FVector* SlotOffsets;
+	int32 NumSlots;
+	uint32 FreeSlotMask;
+	int32 HeldSlot;
+};
+
+/** What AEnemy::DecideThink wants done, applied on the game thread */
+struct FEnemyThinkIntent
+{
+	/** Attack tokens are handed out while applying, the decision covers both answers */
+	EEnemyAIState StateWithToken;
+	EEnemyAIState StateWithoutToken;
+	bool bNeedsToken;
+	bool bReleaseToken;
+	EEnemyThinkAction StayAction;
+	bool bHasTarget;
+	float TargetYaw;
+
+	/** Slot on the target's ring we'd like to wait in, INDEX_NONE when none is free */
+	int32 PreferredSlot;
+};
+
 UCLASS()
 class FIRSTPROJECT_20_API AEnemy : public ACharacter
 {
@@ -29,10 +101,10 @@ public:
 
 	bool bHasValidTarget;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Replicated, Category = "Movement")
 	EEnemyMovementStatus EnemyMovementStatus;
 
-	FORCEINLINE void SetEnemyMovementStatus(EEnemyMovementStatus Status) { EnemyMovementStatus = Status; };
+	void SetEnemyMovementStatus(EEnemyMovementStatus Status);
 	FORCEINLINE EEnemyMovementStatus GetEnemyMovementStatus() { return EnemyMovementStatus; };
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "AI")
@@ -44,9 +116,21 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "AI")
 	class AAIController* AIController;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category= "AI")
+	/** Server value, clients rebuild it from HealthPacked. Change it through SetHealth */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category= "AI")
 	float Health;
 
+	/** Health / MaxHealth in a byte, what actually goes over the network */
+	UPROPERTY(ReplicatedUsing = OnRep_HealthPacked)
+	uint8 HealthPacked;
+
+	UFUNCTION()
+	void OnRep_HealthPacked();
+
+	/** Same contract as AMain::SetHealth */
+	UFUNCTION(BlueprintCallable, Category = "AI")
+	void SetHealth(float NewHealth);
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
 	float MaxHealth;
 
@@ -69,14 +153,21 @@ public:
 	class UAnimMontage* CombatMontage;
 
 
-	FTimerHandle AttackTimer;
-
+	/** Pause before each swing, picked between these */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
 	float AttackMinTime;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
 	float AttackMaxTime;
 
+	/** Leave the attack state after this long even if the montage never called AttackEnd */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
+	float AttackTimeout;
+
+	/** How fast the enemy turns to face its target while fighting */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
+	float FacingInterpSpeed;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Combat")
 	TSubclassOf<UDamageType> DamageTypeClass;
 
@@ -89,6 +180,9 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	/** Nav walking drops the capsule's WorldDynamic response, which weapons and pickups need */
+	virtual void OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PreviousCustomMode = 0) override;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -96,6 +190,8 @@ public:
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	UFUNCTION()
 	virtual void AgroSphereOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult & SweepResult);
 	UFUNCTION()
@@ -109,12 +205,81 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void MoveToTarget(class AMain* Target);
 
+	/** Chase by sampling the shared UFlowFieldSubsystem field instead of pathing on our own */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	bool bUseFlowField;
+
+	/** Within this distance of the target the flow field hands over to a direct MoveTo */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	float FlowFieldHandoverDistance;
+
+	/** Who MoveToTarget is chasing, steered towards in Tick when using the flow field */
+	TWeakObjectPtr<AMain> MoveTarget;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "AI")
+	EEnemyAIState AIState;
+
+	/** Player we're after: seen inside the agro sphere or shared by our squad, acted on by Think */
+	TWeakObjectPtr<AMain> AgroTarget;
+
+	/** Player inside the agro sphere we haven't seen yet, becomes AgroTarget once in sight */
+	TWeakObjectPtr<AMain> AgroCandidate;
+
+	/** Only aggro on players we have line of sight to */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	bool bRequireLineOfSight;
+
+	/** Promote AgroCandidate using UVisibilitySubsystem's cached line of sight */
+	void UpdatePerception();
+
+	/** One step of the state machine, gather, decide and apply in a row */
+	void Think(float Now);
+
+	/**
+	 * The same step split up for UEnemyAISubsystem. DecideThink only reads its input, so
+	 * it runs on worker threads; gather and apply touch the actor and stay on the game thread.
+	 */
+	void GatherThinkInput(float Now, FEnemyThinkInput& Out) const;
+	static void DecideThink(const FEnemyThinkInput& In, FEnemyThinkIntent& Out);
+	void ApplyThinkIntent(const FEnemyThinkIntent& Intent, float Now);
+
+	void SetAIState(EEnemyAIState NewState, float Now);
+
+	/** Move along the navmesh instead of sweeping for floors, see UpdateGroundMovementMode */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	bool bUseNavWalking;
+
+	/** Movable blocking geometry within this distance puts us back on full walking physics */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	float DynamicObstacleRadius;
+
+	/** Walking near moving obstacles or after being knocked off the navmesh, nav walking otherwise */
+	void UpdateGroundMovementMode();
+
+	bool IsNearDynamicObstacle() const;
+
+	/** Only re-path to our surround slot once it moved this far */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	float SlotRepathDistance;
+
+	/** Below this fraction of MaxHealth we leave the swinging to others while the target is already under attack */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	float CautiousHealthFraction;
+
+	/** Direction the flow field wants us to go, false when it has nothing for our cell */
+	bool RequestMoveDirection(FVector& OutDirection) const;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "AI")
 	bool bOverlappingCombatSphere;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "AI")
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Replicated, Category = "AI")
 	AMain* CombatTarget;
 
+	void SetCombatTarget(AMain* Target);
+
+	/** Slot in the server's UHitRewindSubsystem, INDEX_NONE when not tracked */
+	int32 RewindSlot;
+
 	UFUNCTION()
 	void CombatOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult & SweepResult);
 	UFUNCTION()
@@ -126,9 +291,11 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void DeactivateCollision();
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category ="Combat")
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Replicated, Category ="Combat")
 	bool bAttacking;
 
+	void SetAttacking(bool bNewAttacking);
+
 
 	void Attack();
 
@@ -147,4 +314,58 @@ public:
 	bool Alive();
 
 	void Disappear();
+
+	/**
+	 * Park the enemy in (or take it out of) AHordeManager's pool. Pooled enemies are
+	 * hidden, don't collide, tick, think or replicate.
+	 */
+	void SetPooled(bool bNewPooled);
+
+	bool IsPooled() const { return bPooled; }
+
+	/** Number of enemies currently in play (pooled ones don't count), for stats and the CSV profiler */
+	static int32 GetLiveEnemyCount() { return LiveEnemyCount; }
+
+protected:
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	static int32 LiveEnemyCount;
+
+	float StateStartTime;
+	float RecoverEndTime;
+
+	bool bPooled;
+
+	/** Token manager of the player we're fighting, so we can give back what we hold */
+	TWeakObjectPtr<class UAttackTokenComponent> AttackTokenSource;
+
+	/** Where we last sent the AI controller in the surround state */
+	FVector SlotGoal;
+
+	/** Slot DecideThink picked for us, tried first when we claim one */
+	int32 PreferredSlot;
+
+	bool RequestAttackToken(AMain* Target);
+	void ReleaseAttackToken();
+
+	/** Walk to (or keep) our slot around the target while waiting for a token */
+	void MoveToSlot(AMain* Target, bool bForce);
+
+public:
+
+	/** Set when an AEnemySquad drives us instead of an AI controller */
+	TWeakObjectPtr<class AEnemySquad> Squad;
+
+	/** The squad's way of moving us, one direction per frame */
+	void RequestSquadMove(const FVector& Direction);
+
+	/** Where MoveToSlot wants us, for squads walking us there */
+	const FVector& GetSlotGoal() const { return SlotGoal; }
+
+protected:
+
+	/** Yaw Think wants us facing, Tick turns towards it smoothly */
+	float DesiredYaw;
+	bool bHasDesiredYaw;
 };
@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "EnemyAIController.h"
+
+AEnemyAIController::AEnemyAIController(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UCrowdFollowingComponent>(TEXT("PathFollowingComponent")))
+{
+	AvoidanceQuality = ECrowdAvoidanceQuality::Low;
+	bSeparation = true;
+	SeparationWeight = 2.f;
+	CollisionQueryRange = 400.f;
+	PathOptimizationRange = 1000.f;
+}
+
+UCrowdFollowingComponent* AEnemyAIController::GetCrowdFollowing() const
+{
+	return Cast<UCrowdFollowingComponent>(GetPathFollowingComponent());
+}
+
+void AEnemyAIController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	UCrowdFollowingComponent* CrowdFollowing = GetCrowdFollowing();
+	if (CrowdFollowing)
+	{
+		CrowdFollowing->SetCrowdAvoidanceQuality(AvoidanceQuality);
+		CrowdFollowing->SetCrowdSeparation(bSeparation);
+		CrowdFollowing->SetCrowdSeparationWeight(SeparationWeight);
+		CrowdFollowing->SetCrowdCollisionQueryRange(CollisionQueryRange);
+		CrowdFollowing->SetCrowdPathOptimizationRange(PathOptimizationRange);
+	}
+}
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "Navigation/CrowdAgentInterface.h"
+#include "Navigation/CrowdFollowingComponent.h"
+#include "EnemyAIController.generated.h"
+
+/**
+ * AI controller for AEnemy that follows paths through the Detour crowd instead of plain
+ * path following, so packs steer around each other rather than pushing capsules.
+ * The crowd size is the crowd manager's MaxAgents, set in DefaultEngine.ini:
+ *   [/Script/AIModule.CrowdManager]
+ *   MaxAgents=200
+ * Enemies past that fall back to plain path following.
+ */
+UCLASS()
+class FIRSTPROJECT_20_API AEnemyAIController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	AEnemyAIController(const FObjectInitializer& ObjectInitializer);
+
+	/** Low is plenty for melee packs, High for small groups in tight spaces */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	TEnumAsByte<ECrowdAvoidanceQuality::Type> AvoidanceQuality;
+
+	/** Keep some space between agents instead of letting them bunch up on the target */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	bool bSeparation;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float SeparationWeight;
+
+	/** How far around itself an agent looks for others to avoid */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float CollisionQueryRange;
+
+	/** How far ahead along the path the agent can cut corners */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float PathOptimizationRange;
+
+	UCrowdFollowingComponent* GetCrowdFollowing() const;
+
+protected:
+	virtual void OnPossess(APawn* InPawn) override;
+};
@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "EnemyAISubsystem.h"
+#include "FirstProject_20.h"
+#include "Enemy.h"
+#include "Engine/World.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Think"), STAT_EnemyThink, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Enemy Think Gather"), STAT_EnemyThinkGather, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Enemy Think Decide"), STAT_EnemyThinkDecide, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Enemy Think Apply"), STAT_EnemyThinkApply, STATGROUP_FirstProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Thinks"), STAT_EnemyThinks, STATGROUP_FirstProject);
+
+UEnemyAISubsystem::UEnemyAISubsystem()
+{
+	ThinkRate = 8.f;
+	MinParallelBatch = 32;
+	Cursor = 0;
+	PendingThinks = 0.f;
+}
+
+void UEnemyAISubsystem::RegisterEnemy(AEnemy* Enemy)
+{
+	if (Enemy && Enemy->HasAuthority())
+	{
+		Enemies.AddUnique(Enemy);
+	}
+}
+
+void UEnemyAISubsystem::UnregisterEnemy(AEnemy* Enemy)
+{
+	const int32 Index = Enemies.Find(Enemy);
+	if (Index != INDEX_NONE)
+	{
+		// Keep the order so nobody skips or repeats a turn this round
+		Enemies.RemoveAt(Index);
+		if (Index < Cursor)
+		{
+			--Cursor;
+		}
+	}
+}
+
+void UEnemyAISubsystem::Deinitialize()
+{
+	Enemies.Empty();
+
+	Super::Deinitialize();
+}
+
+void UEnemyAISubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemyThink);
+
+	// Every frame, whether or not there are players or enemies around
+	CSV_CUSTOM_STAT(FirstProject, LiveEnemies, AEnemy::GetLiveEnemyCount(), ECsvCustomStatOp::Set);
+
+	const int32 Num = Enemies.Num();
+	if (Num == 0)
+		return;
+	PendingThinks = FMath::Min(PendingThinks + Num * ThinkRate * DeltaTime, (float)Num);
+	const int32 Count = FMath::FloorToInt(PendingThinks);
+	PendingThinks -= Count;
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	{
+		SCOPE_CYCLE_COUNTER(STAT_EnemyThinkGather);
+
+		Batch.Reset();
+		for (int32 i = 0; i < Count; ++i)
+		{
+			if (Cursor >= Enemies.Num())
+			{
+				Cursor = 0;
+			}
+
+			AEnemy* Enemy = Enemies[Cursor++];
+			if (Enemy)
+			{
+				Batch.Add(Enemy);
+			}
+		}
+
+		Inputs.SetNum(Batch.Num(), false);
+		Intents.SetNum(Batch.Num(), false);
+		for (int32 i = 0; i < Batch.Num(); ++i)
+		{
+			Batch[i]->UpdatePerception();
+			Batch[i]->GatherThinkInput(Now, Inputs[i]);
+		}
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_EnemyThinkDecide);
+
+		// Each worker writes only its own intent slot
+		ParallelFor(Batch.Num(), [this](int32 Index)
+		{
+			AEnemy::DecideThink(Inputs[Index], Intents[Index]);
+		}, Batch.Num() < MinParallelBatch);
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_EnemyThinkApply);
+
+		// Applying can unregister enemies (death, pooling), but the batch holds its own pointers
+		for (int32 i = 0; i < Batch.Num(); ++i)
+		{
+			Batch[i]->ApplyThinkIntent(Intents[i], Now);
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_EnemyThinks, Count);
+}
+
+TStatId UEnemyAISubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyAISubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Enemy.h"
+#include "EnemyAISubsystem.generated.h"
+
+/**
+ * Runs the AEnemy state machine for every server enemy at ThinkRate instead of every frame.
+ *
+ * Enemies are visited round robin, a slice per frame sized so each one thinks about
+ * ThinkRate times a second. With 300 enemies at 8 Hz and 60 fps that's 40 thinks every
+ * frame, rather than 300 on one frame and none on the next seven.
+ *
+ * Each slice runs in three passes: snapshot the enemies on the game thread, decide over the
+ * snapshots with ParallelFor, then apply the intents (moves, montages, tokens) on the game thread.
+ */
+UCLASS(Config = Game)
+class FIRSTPROJECT_20_API UEnemyAISubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UEnemyAISubsystem();
+
+	/** Thinks per second per enemy */
+	UPROPERTY(Config)
+	float ThinkRate;
+
+	/** Smaller slices decide on the game thread, not worth waking the workers for */
+	UPROPERTY(Config)
+	int32 MinParallelBatch;
+
+	void RegisterEnemy(AEnemy* Enemy);
+	void UnregisterEnemy(AEnemy* Enemy);
+
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** Ticks with no enemies too, it samples the live enemy count for the CSV profiler */
+	virtual bool IsTickable() const override { return !HasAnyFlags(RF_ClassDefaultObject); }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+protected:
+
+	UPROPERTY(Transient)
+	TArray<AEnemy*> Enemies;
+
+	/** Next enemy to think */
+	int32 Cursor;
+
+	/** Fractional thinks carried over to the next frame */
+	float PendingThinks;
+
+	/** This frame's slice, kept around so the arrays don't reallocate */
+	TArray<AEnemy*> Batch;
+	TArray<FEnemyThinkInput> Inputs;
+	TArray<FEnemyThinkIntent> Intents;
+};
@@ -2,6 +2,7 @@
 
 #include "EnemyAnimInstance.h"
 #include "Enemy.h"
+#include "FirstProjectCosmetics.h"
 
 void UEnemyAnimInstance::NativeInitializeAnimation()
 {
@@ -26,10 +27,13 @@ void UEnemyAnimInstance::UpdateAnimationProperties()
 		}
 	}
 
+#if FIRSTPROJECT_WITH_COSMETICS
+	// Only drives the locomotion pose, montages and their notifies don't need it
 	if (Pawn)
 	{
 		FVector Speed = Pawn->GetVelocity();
 		FVector LateralSpeed = FVector(Speed.X, Speed.Y, 0.f);
 		MovementSpeed = LateralSpeed.Size();
 	}
+#endif
 }
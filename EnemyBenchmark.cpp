@@ -0,0 +1,303 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "EnemyBenchmark.h"
+#include "Engine/World.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "EngineUtils.h"
+#include "UnrealEngine.h"
+#include "Kismet/GameplayStatics.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+#include "FirstProject_20.h"
+#include "SpawnVolume.h"
+#include "Enemy.h"
+#include "Main.h"
+#include "RandomStreamSubsystem.h"
+
+// Sets default values
+AEnemyBenchmark::AEnemyBenchmark()
+{
+ 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	EnemyCounts = { 10, 100, 500, 1000 };
+	WarmupFrames = 120;
+	MeasureFrames = 600;
+	SpawnRadius = 2500.f;
+	PerEnemyMemoryBudgetKB = 0;
+	OutputFile = TEXT("Benchmark/EnemyScaling.json");
+
+	bRunOnBeginPlay = false;
+	bQuitWhenDone = true;
+
+	Phase = EBenchmarkPhase::Idle;
+	StageIndex = 0;
+	PhaseFrame = 0;
+	BaselineUsedPhysical = 0;
+	BaselineEnemyTagBytes = 0;
+}
+
+// Called when the game starts or when spawned
+void AEnemyBenchmark::BeginPlay()
+{
+	Super::BeginPlay();
+	
+	FParse::Value(FCommandLine::Get(), TEXT("EnemyMemoryBudgetKB="), PerEnemyMemoryBudgetKB);
+
+	if (bRunOnBeginPlay || FParse::Param(FCommandLine::Get(), TEXT("EnemyBenchmark")))
+	{
+		StartBenchmark();
+	}
+}
+
+void AEnemyBenchmark::StartBenchmark()
+{
+	if (SpawnVolume == nullptr || EnemyCounts.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("EnemyBenchmark: needs a SpawnVolume and at least one enemy count"));
+		return;
+	}
+
+	// Same placement and combat rolls on every run
+	FMath::RandInit(0);
+	URandomStreamSubsystem* Random = GetGameInstance() ? GetGameInstance()->GetSubsystem<URandomStreamSubsystem>() : nullptr;
+	if (Random)
+	{
+		Random->SetSessionSeed(0);
+	}
+
+	ClearEnemies();
+
+	Results.Reset();
+	StageIndex = 0;
+	PhaseFrame = 0;
+	Phase = EBenchmarkPhase::Spawn;
+	SetActorTickEnabled(true);
+}
+
+// Called every frame
+void AEnemyBenchmark::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	switch (Phase)
+	{
+		case EBenchmarkPhase::Spawn:
+			// Taken a frame after ClearEnemies so the garbage collection has run
+			if (StageIndex == 0)
+			{
+				BaselineUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+				BaselineEnemyTagBytes = GetEnemyTagBytes();
+			}
+			SpawnStage();
+			PhaseFrame = 0;
+			Phase = EBenchmarkPhase::Warmup;
+		break;
+
+		case EBenchmarkPhase::Warmup:
+			DriveCombat();
+			if (++PhaseFrame >= WarmupFrames)
+			{
+				GameThreadTimes.Reset(MeasureFrames);
+				PhaseFrame = 0;
+				Phase = EBenchmarkPhase::Measure;
+			}
+		break;
+
+		case EBenchmarkPhase::Measure:
+			DriveCombat();
+			// Game thread time of the previous frame
+			GameThreadTimes.Add(FPlatformTime::ToMilliseconds(GGameThreadTime));
+			if (++PhaseFrame >= MeasureFrames)
+			{
+				FinishStage();
+			}
+		break;
+
+		default:
+			;
+	}
+}
+
+void AEnemyBenchmark::SpawnStage()
+{
+	UClass* ToSpawn = EnemyClass ? EnemyClass.Get() : SpawnVolume->GetSpawnActor().Get();
+	APawn* Player = UGameplayStatics::GetPlayerPawn(this, 0);
+	FVector Center = Player ? Player->GetActorLocation() : SpawnVolume->GetActorLocation();
+
+	int32 Count = EnemyCounts[StageIndex];
+	for (int32 i = 0; i < Count; i++)
+	{
+		// Spread evenly on the ring, with some jitter so they don't spawn into each other
+		float Angle = (2.f * PI * i) / Count;
+		float Radius = SpawnRadius * URandomStreamSubsystem::Get(this, ERandomStreamId::ERS_Spawning).FRandRange(0.6f, 1.f);
+		FVector Location = Center + FVector(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, 0.f);
+
+		SpawnVolume->SpawnOurActor(ToSpawn, Location);
+	}
+}
+
+void AEnemyBenchmark::DriveCombat()
+{
+	// Scripted player: keep swinging at whatever is closest
+	AMain* Main = Cast<AMain>(UGameplayStatics::GetPlayerPawn(this, 0));
+	if (Main == nullptr || Main->MovementStatus == EMovementStatus::EMS_Dead)
+		return;
+
+	// The benchmark measures the cost of the fight, not the player dying
+	Main->SetHealth(Main->MaxHealth);
+
+	if (Main->EquippedWeapon)
+	{
+		Main->bLMBDown = true;
+		Main->UpdateCombatTarget();
+		Main->Attack();
+	}
+}
+
+void AEnemyBenchmark::FinishStage()
+{
+	GameThreadTimes.Sort();
+
+	FStageResult Result;
+	Result.EnemyCount = EnemyCounts[StageIndex];
+	Result.LiveEnemies = AEnemy::GetLiveEnemyCount();
+	Result.P50 = Percentile(GameThreadTimes, 0.50f);
+	Result.P95 = Percentile(GameThreadTimes, 0.95f);
+	Result.P99 = Percentile(GameThreadTimes, 0.99f);
+
+	float Total = 0.f;
+	for (float Time : GameThreadTimes)
+	{
+		Total += Time;
+	}
+	Result.Average = GameThreadTimes.Num() > 0 ? Total / GameThreadTimes.Num() : 0.f;
+
+	// Process memory moves with the allocator and everything else in the game, only the
+	// LLM tag of the enemy spawn sites is precise enough to hold a budget against
+	Result.UsedPhysicalBytes = FPlatformMemory::GetStats().UsedPhysical;
+	Result.EnemyTagBytes = GetEnemyTagBytes();
+	const bool bHasTag = Result.EnemyTagBytes >= 0 && BaselineEnemyTagBytes >= 0;
+	Result.BytesPerEnemy = bHasTag && Result.LiveEnemies > 0 ? (Result.EnemyTagBytes - BaselineEnemyTagBytes) / Result.LiveEnemies : 0;
+	Result.bWithinBudget = PerEnemyMemoryBudgetKB <= 0 || (bHasTag && Result.BytesPerEnemy <= (int64)PerEnemyMemoryBudgetKB * 1024);
+
+	if (PerEnemyMemoryBudgetKB > 0 && !bHasTag)
+	{
+		UE_LOG(LogTemp, Error, TEXT("EnemyBenchmark: the memory budget needs LLM, run with -llm"));
+	}
+	else if (!Result.bWithinBudget)
+	{
+		UE_LOG(LogTemp, Error, TEXT("EnemyBenchmark: %d enemies cost %lld bytes each, budget is %d KB"),
+			Result.EnemyCount, Result.BytesPerEnemy, PerEnemyMemoryBudgetKB);
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("EnemyBenchmark: %d enemies (%d alive) p50 %.2fms p95 %.2fms p99 %.2fms, %lld bytes/enemy"),
+		Result.EnemyCount, Result.LiveEnemies, Result.P50, Result.P95, Result.P99, Result.BytesPerEnemy);
+
+	Results.Add(Result);
+
+	ClearEnemies();
+
+	if (++StageIndex < EnemyCounts.Num())
+	{
+		Phase = EBenchmarkPhase::Spawn;
+		return;
+	}
+
+	Phase = EBenchmarkPhase::Done;
+	SetActorTickEnabled(false);
+	WriteResults();
+
+	if (bQuitWhenDone)
+	{
+		bool bPassed = Results.FindByPredicate([](const FStageResult& Result) { return !Result.bWithinBudget; }) == nullptr;
+		FPlatformMisc::RequestExitWithStatus(false, bPassed ? 0 : 1);
+	}
+}
+
+void AEnemyBenchmark::ClearEnemies()
+{
+	for (TActorIterator<AEnemy> It(GetWorld()); It; ++It)
+	{
+		if (It->Controller)
+		{
+			It->Controller->Destroy();
+		}
+		It->Destroy();
+	}
+
+	// Give the memory back before the next stage is measured
+	GEngine->ForceGarbageCollection(true);
+}
+
+void AEnemyBenchmark::WriteResults()
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("map"), GetWorld()->GetMapName());
+	Root->SetStringField(TEXT("build"), FApp::GetBuildVersion());
+	Root->SetNumberField(TEXT("measureFrames"), MeasureFrames);
+	Root->SetNumberField(TEXT("baselineUsedPhysical"), (double)BaselineUsedPhysical);
+	Root->SetNumberField(TEXT("baselineEnemyTagBytes"), (double)BaselineEnemyTagBytes);
+	Root->SetNumberField(TEXT("perEnemyMemoryBudgetKB"), PerEnemyMemoryBudgetKB);
+
+	TArray<TSharedPtr<FJsonValue>> Stages;
+	for (const FStageResult& Result : Results)
+	{
+		TSharedRef<FJsonObject> Stage = MakeShared<FJsonObject>();
+		Stage->SetNumberField(TEXT("enemyCount"), Result.EnemyCount);
+		Stage->SetNumberField(TEXT("liveEnemies"), Result.LiveEnemies);
+		Stage->SetNumberField(TEXT("gameThreadMsP50"), Result.P50);
+		Stage->SetNumberField(TEXT("gameThreadMsP95"), Result.P95);
+		Stage->SetNumberField(TEXT("gameThreadMsP99"), Result.P99);
+		Stage->SetNumberField(TEXT("gameThreadMsAvg"), Result.Average);
+		Stage->SetNumberField(TEXT("usedPhysical"), (double)Result.UsedPhysicalBytes);
+		Stage->SetNumberField(TEXT("enemyTagBytes"), (double)Result.EnemyTagBytes);
+		Stage->SetNumberField(TEXT("bytesPerEnemy"), (double)Result.BytesPerEnemy);
+		Stage->SetBoolField(TEXT("withinBudget"), Result.bWithinBudget);
+		Stages.Add(MakeShared<FJsonValueObject>(Stage));
+	}
+	Root->SetArrayField(TEXT("stages"), Stages);
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Root, Writer);
+
+	FString Path = FPaths::Combine(FPaths::ProjectSavedDir(), OutputFile);
+	if (FFileHelper::SaveStringToFile(Json, *Path))
+	{
+		UE_LOG(LogTemp, Display, TEXT("EnemyBenchmark: results written to %s"), *Path);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("EnemyBenchmark: can't write %s"), *Path);
+	}
+}
+
+int64 AEnemyBenchmark::GetEnemyTagBytes()
+{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	FLowLevelMemTracker& Tracker = FLowLevelMemTracker::Get();
+	if (Tracker.IsEnabled())
+	{
+		return Tracker.GetTagAmountForTracker(ELLMTracker::Default, LLM_TAGDECLARATION_BY_NAME(FirstProject_Enemies).GetUniqueName());
+	}
+#endif
+	return -1;
+}
+
+float AEnemyBenchmark::Percentile(const TArray<float>& SortedValues, float Fraction)
+{
+	if (SortedValues.Num() == 0)
+		return 0.f;
+
+	int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * SortedValues.Num()) - 1, 0, SortedValues.Num() - 1);
+	return SortedValues[Index];
+}
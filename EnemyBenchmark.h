@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "EnemyBenchmark.generated.h"
+
+/**
+ * Frame-time benchmark for scaling with enemy count. Place one in the benchmark map
+ * next to an ASpawnVolume and run headless, e.g.
+ *   FirstProject_20 BenchmarkMap -game -nullrhi -unattended -EnemyBenchmark
+ * For every entry in EnemyCounts it spawns that many enemies around the player,
+ * lets them fight the player for a fixed number of frames and records game thread
+ * time and memory. Results are written as JSON to OutputFile.
+ * With PerEnemyMemoryBudgetKB set (or -EnemyMemoryBudgetKB=N) a stage going over the
+ * budget fails the run, and the process exits with a non-zero code. The budget is checked
+ * against the FirstProject_Enemies LLM tag, so the check needs -llm; without it the run fails.
+ */
+UCLASS()
+class FIRSTPROJECT_20_API AEnemyBenchmark : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	// Sets default values for this actor's properties
+	AEnemyBenchmark();
+
+	/** Volume used to spawn the enemies */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark")
+	class ASpawnVolume* SpawnVolume;
+
+	/** Enemy to spawn, falls back to the spawn volume's own selection */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark")
+	TSubclassOf<class AEnemy> EnemyClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark")
+	TArray<int32> EnemyCounts;
+
+	/** Frames to let spawning and aggro settle before measuring */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark")
+	int32 WarmupFrames;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark")
+	int32 MeasureFrames;
+
+	/** Enemies are placed on a ring of this radius around the player */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark")
+	float SpawnRadius;
+
+	/** Memory one enemy may cost under the FirstProject_Enemies LLM tag (actor, components, controller, anim instance), 0 turns the check off */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark")
+	int32 PerEnemyMemoryBudgetKB;
+
+	/** Relative to the project Saved directory */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark")
+	FString OutputFile;
+
+	/** Run without the -EnemyBenchmark switch, handy in PIE */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark")
+	bool bRunOnBeginPlay;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Benchmark")
+	bool bQuitWhenDone;
+
+	UFUNCTION(BlueprintCallable, Category = "Benchmark")
+	void StartBenchmark();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+public:	
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+protected:
+
+	enum class EBenchmarkPhase : uint8
+	{
+		Idle,
+		Spawn,
+		Warmup,
+		Measure,
+		Done
+	};
+
+	struct FStageResult
+	{
+		int32 EnemyCount;
+		int32 LiveEnemies;
+		float P50;
+		float P95;
+		float P99;
+		float Average;
+		uint64 UsedPhysicalBytes;
+		int64 EnemyTagBytes;
+		int64 BytesPerEnemy;
+		bool bWithinBudget;
+	};
+
+	void SpawnStage();
+	void FinishStage();
+	void ClearEnemies();
+	void DriveCombat();
+	void WriteResults();
+
+	static float Percentile(const TArray<float>& SortedValues, float Fraction);
+
+	EBenchmarkPhase Phase;
+	int32 StageIndex;
+	int32 PhaseFrame;
+
+	/** Memory with no enemies spawned */
+	uint64 BaselineUsedPhysical;
+
+	/** FirstProject_Enemies LLM tag with no enemies spawned, the baseline for per-enemy cost */
+	int64 BaselineEnemyTagBytes;
+
+	/** Bytes under the FirstProject_Enemies LLM tag, -1 when LLM isn't running */
+	static int64 GetEnemyTagBytes();
+
+	TArray<float> GameThreadTimes;
+	TArray<FStageResult> Results;
+};
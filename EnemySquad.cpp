@@ -0,0 +1,257 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "EnemySquad.h"
+#include "FirstProject_20.h"
+#include "Enemy.h"
+#include "Main.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "NavigationSystem.h"
+#include "NavigationPath.h"
+
+DECLARE_CYCLE_STAT(TEXT("Enemy Squad Tick"), STAT_EnemySquadTick, STATGROUP_FirstProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Squad Paths"), STAT_EnemySquadPaths, STATGROUP_FirstProject);
+
+// Sets default values
+AEnemySquad::AEnemySquad()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// Pure server bookkeeping, the members replicate themselves
+	bReplicates = false;
+
+	SightRadius = 600.f;
+	TargetMemoryTime = 5.f;
+	RepathInterval = 0.5f;
+	DirectChaseRadius = 600.f;
+	CohesionRadius = 400.f;
+	SeparationRadius = 120.f;
+	SeparationWeight = 1.5f;
+
+	LastSeenTime = 0.f;
+	bHadMembers = false;
+	PathIndex = 0;
+	LastPathTime = -MAX_FLT;
+}
+
+void AEnemySquad::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (!HasAuthority())
+	{
+		SetActorTickEnabled(false);
+	}
+}
+
+void AEnemySquad::AddMember(AEnemy* Enemy)
+{
+	if (Enemy == nullptr || Members.Contains(Enemy))
+		return;
+
+	Members.Add(Enemy);
+	Enemy->Squad = this;
+	bHadMembers = true;
+
+	// No controller to consume input for them, and nobody to turn them but their movement
+	UCharacterMovementComponent* Movement = Enemy->GetCharacterMovement();
+	Movement->bRunPhysicsWithNoController = true;
+	Movement->bOrientRotationToMovement = true;
+	Enemy->bUseControllerRotationYaw = false;
+}
+
+void AEnemySquad::RemoveMember(AEnemy* Enemy)
+{
+	Members.Remove(Enemy);
+	if (Enemy && Enemy->Squad == this)
+	{
+		Enemy->Squad.Reset();
+	}
+}
+
+// Called every frame
+void AEnemySquad::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EnemySquadTick);
+
+	Super::Tick(DeltaTime);
+
+	Members.RemoveAll([](AEnemy* Enemy) { return !IsValid(Enemy) || !Enemy->Alive(); });
+	if (Members.Num() == 0)
+	{
+		if (bHadMembers)
+		{
+			Destroy();
+		}
+		return;
+	}
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	UpdateTarget(Now);
+	UpdatePath(Now);
+	SteerMembers();
+}
+
+void AEnemySquad::UpdateTarget(float Now)
+{
+	// Whoever a member has aggro on becomes the whole squad's target
+	for (AEnemy* Enemy : Members)
+	{
+		if (AMain* Seen = Enemy->AgroTarget.Get())
+		{
+			Target = Seen;
+			break;
+		}
+	}
+
+	AMain* Current = Target.Get();
+	if (Current == nullptr)
+		return;
+
+	const float SightSq = SightRadius * SightRadius;
+	for (const AEnemy* Enemy : Members)
+	{
+		if (FVector::DistSquared(Enemy->GetActorLocation(), Current->GetActorLocation()) < SightSq)
+		{
+			LastSeenTime = Now;
+			break;
+		}
+	}
+
+	const bool bForget = Now - LastSeenTime > TargetMemoryTime;
+	if (bForget)
+	{
+		Target.Reset();
+		PathPoints.Reset();
+	}
+
+	for (AEnemy* Enemy : Members)
+	{
+		if (bForget)
+		{
+			Enemy->AgroTarget.Reset();
+		}
+		else
+		{
+			Enemy->AgroTarget = Current;
+		}
+	}
+}
+
+void AEnemySquad::UpdatePath(float Now)
+{
+	AMain* Current = Target.Get();
+	if (Current == nullptr || Now - LastPathTime < RepathInterval)
+		return;
+
+	LastPathTime = Now;
+
+	// One request for everybody, from the leader
+	UNavigationPath* Path = UNavigationSystemV1::FindPathToLocationSynchronously(this, Members[0]->GetActorLocation(), Current->GetActorLocation(), this);
+	INC_DWORD_STAT(STAT_EnemySquadPaths);
+
+	PathPoints.Reset();
+	PathIndex = 0;
+	if (Path && Path->IsValid())
+	{
+		PathPoints = Path->PathPoints;
+	}
+}
+
+void AEnemySquad::SteerMembers()
+{
+	AMain* Current = Target.Get();
+	if (Current == nullptr)
+		return;
+
+	const FVector Leader = Members[0]->GetActorLocation();
+	const FVector TargetLocation = Current->GetActorLocation();
+
+	// Advance along the shared path as the leader passes its points
+	while (PathPoints.IsValidIndex(PathIndex + 1) && FVector::DistSquared2D(Leader, PathPoints[PathIndex]) < FMath::Square(150.f))
+	{
+		++PathIndex;
+	}
+	const FVector PathGoal = PathPoints.IsValidIndex(PathIndex) ? PathPoints[PathIndex] : TargetLocation;
+
+	const float DirectSq = DirectChaseRadius * DirectChaseRadius;
+	const float CohesionSq = CohesionRadius * CohesionRadius;
+	const float SeparationSq = SeparationRadius * SeparationRadius;
+
+	MemberLocations.Reset(Members.Num());
+	for (const AEnemy* Enemy : Members)
+	{
+		MemberLocations.Add(Enemy->GetActorLocation());
+	}
+
+	for (int32 Index = 0; Index < Members.Num(); ++Index)
+	{
+		AEnemy* Enemy = Members[Index];
+		const FVector Location = MemberLocations[Index];
+		FVector Goal;
+
+		switch (Enemy->AIState)
+		{
+		case EEnemyAIState::EAS_Chase:
+			if (Enemy->bUseFlowField)
+				continue;
+
+			if (Enemy->bOverlappingCombatSphere)
+				continue;
+
+			if (FVector::DistSquared2D(Location, TargetLocation) < DirectSq)
+			{
+				Goal = TargetLocation;
+			}
+			else if (FVector::DistSquared2D(Location, Leader) > CohesionSq)
+			{
+				Goal = Leader;
+			}
+			else
+			{
+				// Walk the path with the same offset from the leader we have now,
+				// the offset can put it off the mesh around corners
+				Goal = ProjectGoal(PathGoal + (Location - Leader), PathGoal);
+			}
+			break;
+
+		case EEnemyAIState::EAS_Surround:
+			if (FVector::DistSquared2D(Location, Enemy->GetSlotGoal()) < FMath::Square(50.f))
+				continue;
+
+			// Ring slots are plain offsets from the target, they can land in a wall
+			Goal = ProjectGoal(Enemy->GetSlotGoal(), Location);
+			break;
+
+		default:
+			continue;
+		}
+
+		// Push away from members that are too close, harder the closer they are
+		FVector Separation = FVector::ZeroVector;
+		for (int32 Other = 0; Other < MemberLocations.Num(); ++Other)
+		{
+			const FVector Away = Location - MemberLocations[Other];
+			const float DistSq = Away.SizeSquared2D();
+			if (Other == Index || DistSq >= SeparationSq || DistSq < KINDA_SMALL_NUMBER)
+				continue;
+
+			const float Dist = FMath::Sqrt(DistSq);
+			Separation += FVector(Away.X, Away.Y, 0.f) / Dist * (1.f - Dist / SeparationRadius);
+		}
+
+		const FVector Direction = (Goal - Location).GetSafeNormal2D() + Separation * SeparationWeight;
+		Enemy->RequestSquadMove(Direction.GetClampedToMaxSize(1.f));
+	}
+}
+
+FVector AEnemySquad::ProjectGoal(const FVector& Goal, const FVector& Fallback) const
+{
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	FNavLocation NavLocation;
+	if (NavSys && NavSys->ProjectPointToNavigation(Goal, NavLocation, FVector(100.f, 100.f, 250.f)))
+	{
+		return NavLocation.Location;
+	}
+	return NavSys ? Fallback : Goal;
+}
@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "EnemySquad.generated.h"
+
+class AEnemy;
+class AMain;
+
+/**
+ * One brain for a group of controller-less enemies, server only.
+ *
+ * Members still run their own combat state machine (AEnemy::Think), but they share the
+ * squad's target memory and movement. The squad keeps one path from its leader to the target
+ * and steers every chasing member along it through AEnemy::RequestSquadMove, all from
+ * this actor's single tick. That replaces an AAIController with its own path following
+ * for each enemy.
+ */
+UCLASS()
+class FIRSTPROJECT_20_API AEnemySquad : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AEnemySquad();
+
+	/** A member has to be this close to the target for the squad to count as seeing it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Squad")
+	float SightRadius;
+
+	/** Keep chasing this long after nobody sees the target anymore */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Squad")
+	float TargetMemoryTime;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Squad")
+	float RepathInterval;
+
+	/** Inside this distance members leave the path and go straight for the target */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Squad")
+	float DirectChaseRadius;
+
+	/** Members further than this from the leader are pulled back towards it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Squad")
+	float CohesionRadius;
+
+	/**
+	 * Members closer than this push each other apart. Without a crowd agent and with
+	 * ECC_Enemy ignored, nothing else keeps them from walking into one another
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Squad")
+	float SeparationRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Squad")
+	float SeparationWeight;
+
+	void AddMember(AEnemy* Enemy);
+	void RemoveMember(AEnemy* Enemy);
+
+	int32 GetNumMembers() const { return Members.Num(); }
+
+	AMain* GetTarget() const { return Target.Get(); }
+
+protected:
+
+	virtual void BeginPlay() override;
+
+public:
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+protected:
+
+	UPROPERTY(Transient)
+	TArray<AEnemy*> Members;
+
+	TWeakObjectPtr<AMain> Target;
+	float LastSeenTime;
+
+	/** Squads go away once everyone in them is gone */
+	bool bHadMembers;
+
+	/** Shared path from the leader to the target */
+	TArray<FVector> PathPoints;
+	int32 PathIndex;
+	float LastPathTime;
+
+	void UpdateTarget(float Now);
+	void UpdatePath(float Now);
+	void SteerMembers();
+
+	/** Goal moved onto the navmesh, or Fallback if it's off the mesh */
+	FVector ProjectGoal(const FVector& Goal, const FVector& Fallback) const;
+
+	/** Member locations for this tick's separation, same order as Members */
+	TArray<FVector> MemberLocations;
+};
@@ -3,6 +3,7 @@
 #include "Explosive.h"
 #include "Main.h"
 #include "Kismet/GameplayStatics.h"
+#include "FirstProjectCosmetics.h"
 #include "Engine/World.h"
 #include "Sound/SoundCue.h"
 #include "Enemy.h"
@@ -30,12 +31,12 @@ void AExplosive::OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor
 		{
 			if (OverlapParticles)
 			{
-				UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), OverlapParticles, GetActorLocation(), FRotator(0.f), true);
+				FFirstProjectCosmetics::SpawnEmitterAtLocation(this, OverlapParticles, GetActorLocation(), true);
 			}
 
 			if (OverlapSound)
 			{
-				UGameplayStatics::PlaySound2D(this, OverlapSound);
+				FFirstProjectCosmetics::PlaySound2D(this, OverlapSound);
 			}
 
 			//Main->DecrementHealth(Damage);
@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstProjectCosmetics.h"
+
+#if FIRSTPROJECT_WITH_COSMETICS
+
+#include "Engine/Engine.h"
+#include "Misc/App.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+
+bool FFirstProjectCosmetics::ShouldPlayCosmetics(const UObject* WorldContextObject)
+{
+	const UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	return World && World->GetNetMode() != NM_DedicatedServer;
+}
+
+bool FFirstProjectCosmetics::ShouldCreateWidgets(const APlayerController* PlayerController)
+{
+	// -nullrhi processes (bot clients) have no viewport either
+	return PlayerController && PlayerController->IsLocalController() && FApp::CanEverRender() && ShouldPlayCosmetics(PlayerController);
+}
+
+void FFirstProjectCosmetics::PlaySound2D(const UObject* WorldContextObject, USoundBase* Sound)
+{
+	if (Sound && ShouldPlayCosmetics(WorldContextObject))
+	{
+		UGameplayStatics::PlaySound2D(WorldContextObject, Sound);
+	}
+}
+
+void FFirstProjectCosmetics::SpawnEmitterAtLocation(const UObject* WorldContextObject, UParticleSystem* Emitter, const FVector& Location, bool bAutoDestroy)
+{
+	if (Emitter && ShouldPlayCosmetics(WorldContextObject))
+	{
+		UGameplayStatics::SpawnEmitterAtLocation(WorldContextObject, Emitter, Location, FRotator(0.f), bAutoDestroy);
+	}
+}
+
+#endif // FIRSTPROJECT_WITH_COSMETICS
@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USoundBase;
+class UParticleSystem;
+class APlayerController;
+
+/**
+ * Sounds, particles, widgets and anim properties nobody sees on a dedicated server.
+ * The Server target (UE_SERVER) compiles everything inside #if FIRSTPROJECT_WITH_COSMETICS
+ * out and the helpers below become empty inlines. Other builds can still be launched
+ * as a server (-server), so their one runtime check lives in ShouldPlayCosmetics.
+ */
+#if !defined(FIRSTPROJECT_WITH_COSMETICS)
+	#define FIRSTPROJECT_WITH_COSMETICS !UE_SERVER
+#endif
+
+struct FIRSTPROJECT_20_API FFirstProjectCosmetics
+{
+#if FIRSTPROJECT_WITH_COSMETICS
+	/** False when WorldContextObject's world runs as a dedicated server */
+	static bool ShouldPlayCosmetics(const UObject* WorldContextObject);
+
+	/** Only local controllers on a machine that renders get widgets */
+	static bool ShouldCreateWidgets(const APlayerController* PlayerController);
+
+	static void PlaySound2D(const UObject* WorldContextObject, USoundBase* Sound);
+	static void SpawnEmitterAtLocation(const UObject* WorldContextObject, UParticleSystem* Emitter, const FVector& Location, bool bAutoDestroy = true);
+#else
+	static FORCEINLINE bool ShouldPlayCosmetics(const UObject* WorldContextObject) { return false; }
+	static FORCEINLINE bool ShouldCreateWidgets(const APlayerController* PlayerController) { return false; }
+	static FORCEINLINE void PlaySound2D(const UObject* WorldContextObject, USoundBase* Sound) {}
+	static FORCEINLINE void SpawnEmitterAtLocation(const UObject* WorldContextObject, UParticleSystem* Emitter, const FVector& Location, bool bAutoDestroy = true) {}
+#endif
+};
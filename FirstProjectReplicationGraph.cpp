@@ -0,0 +1,185 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstProjectReplicationGraph.h"
+#include "ReplicationGraphTypes.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/LevelScriptActor.h"
+#include "Item.h"
+#include "Weapon.h"
+#include "FloorSwitch.h"
+
+UFirstProjectReplicationGraph::UFirstProjectReplicationGraph()
+{
+	GridCellSize = 10000.f;
+	SpatialBias = FVector2D(-150000.f, -150000.f);
+	DefaultCullDistance = 15000.f;
+
+	GridNode = nullptr;
+	AlwaysRelevantNode = nullptr;
+}
+
+UFirstProjectReplicationGraph::EClassRouting UFirstProjectReplicationGraph::GetRouting(const UClass* Class) const
+{
+	if (Class->IsChildOf(ALevelScriptActor::StaticClass()))
+	{
+		return EClassRouting::NotRouted;
+	}
+	if (Class->IsChildOf(APlayerController::StaticClass()) || Class->GetDefaultObject<AActor>()->bOnlyRelevantToOwner)
+	{
+		return EClassRouting::OwnerOnly;
+	}
+	if (Class->IsChildOf(AInfo::StaticClass()))
+	{
+		return EClassRouting::AlwaysRelevant;
+	}
+	if (Class->IsChildOf(AWeapon::StaticClass()))
+	{
+		// Carried around once equipped, a fixed dormant cell would lose track of it
+		return EClassRouting::Dynamic;
+	}
+	if (Class->IsChildOf(AItem::StaticClass()) || Class->IsChildOf(AFloorSwitch::StaticClass()))
+	{
+		return EClassRouting::Dormant;
+	}
+	if (Class->IsChildOf(APawn::StaticClass()))
+	{
+		return EClassRouting::Dynamic;
+	}
+	return Class->GetDefaultObject<AActor>()->IsReplicatingMovement() ? EClassRouting::Dynamic : EClassRouting::Static;
+}
+
+void UFirstProjectReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Every replicated class uses its own NetUpdateFrequency and cull distance
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject(false));
+		if (!ActorCDO || !ActorCDO->GetIsReplicated()) continue;
+		if (Class->HasAnyClassFlags(CLASS_Abstract) || Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_"))) continue;
+
+		FClassReplicationInfo ClassInfo;
+		const float CullDistanceSquared = ActorCDO->NetCullDistanceSquared > 0.f ? ActorCDO->NetCullDistanceSquared : FMath::Square(DefaultCullDistance);
+		ClassInfo.SetCullDistanceSquared(CullDistanceSquared);
+		ClassInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(FMath::Max(ActorCDO->NetUpdateFrequency, 1.f));
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void UFirstProjectReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = SpatialBias;
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void UFirstProjectReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch (GetRouting(ActorInfo.Class))
+	{
+		case EClassRouting::OwnerOnly:
+			// Usually has no connection yet, ServerReplicateActors hands it over once it does
+			PendingOwnerActors.AddUnique(ActorInfo.Actor);
+			break;
+		case EClassRouting::AlwaysRelevant:
+			AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+			break;
+		case EClassRouting::Static:
+			GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+			break;
+		case EClassRouting::Dormant:
+			GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+			break;
+		case EClassRouting::Dynamic:
+			GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+			break;
+		default:
+			;
+	}
+}
+
+void UFirstProjectReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch (GetRouting(ActorInfo.Class))
+	{
+		case EClassRouting::OwnerOnly:
+			PendingOwnerActors.Remove(ActorInfo.Actor);
+			for (auto& Pair : OwnerNodes)
+			{
+				Pair.Value->NotifyRemoveNetworkActor(ActorInfo, false);
+			}
+			break;
+		case EClassRouting::AlwaysRelevant:
+			AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+			break;
+		case EClassRouting::Static:
+			GridNode->RemoveActor_Static(ActorInfo);
+			break;
+		case EClassRouting::Dormant:
+			GridNode->RemoveActor_Dormancy(ActorInfo);
+			break;
+		case EClassRouting::Dynamic:
+			GridNode->RemoveActor_Dynamic(ActorInfo);
+			break;
+		default:
+			;
+	}
+}
+
+void UFirstProjectReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* ConnectionManager)
+{
+	Super::InitConnectionGraphNodes(ConnectionManager);
+
+	// Besides what we add, this node always gathers the connection's viewer and view target
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* OwnerNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(OwnerNode, ConnectionManager);
+	OwnerNodes.Add(ConnectionManager, OwnerNode);
+}
+
+void UFirstProjectReplicationGraph::RemoveClientConnection(UNetConnection* NetConnection)
+{
+	for (auto It = OwnerNodes.CreateIterator(); It; ++It)
+	{
+		if (It->Key == nullptr || It->Key->NetConnection == NetConnection)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	Super::RemoveClientConnection(NetConnection);
+}
+
+int32 UFirstProjectReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	for (int32 i = PendingOwnerActors.Num() - 1; i >= 0; --i)
+	{
+		AActor* Actor = PendingOwnerActors[i];
+		if (!IsValid(Actor))
+		{
+			PendingOwnerActors.RemoveAtSwap(i, 1, false);
+			continue;
+		}
+
+		UNetConnection* Connection = Actor->GetNetConnection();
+		if (Connection == nullptr)
+			continue;
+
+		UNetReplicationGraphConnection* ConnectionManager = FindOrAddConnectionManager(Connection);
+		UReplicationGraphNode_AlwaysRelevant_ForConnection** OwnerNode = ConnectionManager ? OwnerNodes.Find(ConnectionManager) : nullptr;
+		if (OwnerNode && *OwnerNode)
+		{
+			(*OwnerNode)->NotifyAddNetworkActor(FNewReplicatedActorInfo(Actor));
+			PendingOwnerActors.RemoveAtSwap(i, 1, false);
+		}
+	}
+
+	return Super::ServerReplicateActors(DeltaSeconds);
+}
\ No newline at end of file
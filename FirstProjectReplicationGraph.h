@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "FirstProjectReplicationGraph.generated.h"
+
+class UReplicationGraphNode_GridSpatialization2D;
+class UReplicationGraphNode_ActorList;
+class UReplicationGraphNode_AlwaysRelevant_ForConnection;
+
+/**
+ * Spatialized relevancy for dedicated servers. Enable with
+ * [/Script/OnlineSubsystemUtils.IpNetDriver] ReplicationDriverClassName="/Script/FirstProject_20.FirstProjectReplicationGraph"
+ *
+ * Placed items, pickups, explosives and floor switches go into the grid as dormant actors,
+ * so they cost nothing until they flush. Characters and weapons, which ride along with
+ * them once equipped, go into the grid as dynamic actors. Infos (game state, player states)
+ * are always relevant. Player controllers and other owner-only actors go to a per-connection
+ * node for their owner, which also always holds the connection's pawn and view target.
+ */
+UCLASS(Transient, config = Engine)
+class FIRSTPROJECT_20_API UFirstProjectReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	UFirstProjectReplicationGraph();
+
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* ConnectionManager) override;
+	virtual void RemoveClientConnection(UNetConnection* NetConnection) override;
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+	/** Size of one grid cell, a connection only looks at the cells its view overlaps */
+	UPROPERTY(Config)
+	float GridCellSize;
+
+	/** Actors outside these bounds still work, the grid just grows to hold them */
+	UPROPERTY(Config)
+	FVector2D SpatialBias;
+
+	/** Cull distance for actors that don't set their own */
+	UPROPERTY(Config)
+	float DefaultCullDistance;
+
+	UPROPERTY()
+	UReplicationGraphNode_GridSpatialization2D* GridNode;
+
+	UPROPERTY()
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode;
+
+	/** Per connection: its controller, pawn and anything else only its owner should get */
+	UPROPERTY()
+	TMap<UNetReplicationGraphConnection*, UReplicationGraphNode_AlwaysRelevant_ForConnection*> OwnerNodes;
+
+	/** Owner-only actors waiting for a net connection before they can go into an OwnerNode */
+	UPROPERTY()
+	TArray<AActor*> PendingOwnerActors;
+
+private:
+	enum class EClassRouting : uint8
+	{
+		NotRouted,
+		OwnerOnly,
+		AlwaysRelevant,
+		Static,
+		Dormant,
+		Dynamic,
+	};
+
+	EClassRouting GetRouting(const UClass* Class) const;
+};
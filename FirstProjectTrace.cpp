@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FirstProjectTrace.h"
+
+#if FIRSTPROJECT_TRACE_ENABLED
+
+#include "GameFramework/Actor.h"
+#include "ProfilingDebugging/MiscTrace.h"
+#include "ProfilingDebugging/CountersTrace.h"
+
+UE_TRACE_CHANNEL_DEFINE(FirstProjectChannel);
+
+TRACE_DECLARE_INT_COUNTER(FirstProject_EnemyStateChanges, TEXT("FirstProject/EnemyStateChanges"));
+TRACE_DECLARE_INT_COUNTER(FirstProject_DamageEvents, TEXT("FirstProject/DamageEvents"));
+TRACE_DECLARE_FLOAT_COUNTER(FirstProject_DamageAmount, TEXT("FirstProject/DamageAmount"));
+TRACE_DECLARE_INT_COUNTER(FirstProject_Spawns, TEXT("FirstProject/Spawns"));
+
+UE_TRACE_EVENT_BEGIN(FirstProject, EnemyState)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, ActorId)
+	UE_TRACE_EVENT_FIELD(uint8, State)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(FirstProject, Damage)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, VictimId)
+	UE_TRACE_EVENT_FIELD(uint32, CauserId)
+	UE_TRACE_EVENT_FIELD(float, Amount)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(FirstProject, Death)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, ActorId)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(FirstProject, Spawn)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, SpawnerId)
+	UE_TRACE_EVENT_FIELD(uint32, ActorId)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(FirstProject, SaveLoad)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, ActorId)
+	UE_TRACE_EVENT_FIELD(bool, bLoad)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(FirstProject, LevelTransition)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(Trace::WideString, FromLevel)
+	UE_TRACE_EVENT_FIELD(Trace::WideString, ToLevel)
+UE_TRACE_EVENT_END()
+
+namespace
+{
+	uint32 TraceId(const AActor* Actor)
+	{
+		return Actor ? Actor->GetUniqueID() : 0;
+	}
+}
+
+void FFirstProjectTrace::OutputEnemyState(const AActor* Enemy, uint8 State)
+{
+	UE_TRACE_LOG(FirstProject, EnemyState, FirstProjectChannel)
+		<< EnemyState.Cycle(FPlatformTime::Cycles64())
+		<< EnemyState.ActorId(TraceId(Enemy))
+		<< EnemyState.State(State);
+
+	TRACE_COUNTER_INCREMENT(FirstProject_EnemyStateChanges);
+}
+
+void FFirstProjectTrace::OutputDamage(const AActor* Victim, const AActor* Causer, float Amount)
+{
+	UE_TRACE_LOG(FirstProject, Damage, FirstProjectChannel)
+		<< Damage.Cycle(FPlatformTime::Cycles64())
+		<< Damage.VictimId(TraceId(Victim))
+		<< Damage.CauserId(TraceId(Causer))
+		<< Damage.Amount(Amount);
+
+	TRACE_COUNTER_INCREMENT(FirstProject_DamageEvents);
+	TRACE_COUNTER_ADD(FirstProject_DamageAmount, Amount);
+}
+
+void FFirstProjectTrace::OutputDeath(const AActor* Actor)
+{
+	UE_TRACE_LOG(FirstProject, Death, FirstProjectChannel)
+		<< Death.Cycle(FPlatformTime::Cycles64())
+		<< Death.ActorId(TraceId(Actor));
+
+	TRACE_BOOKMARK(TEXT("Death %s"), *GetNameSafe(Actor));
+}
+
+void FFirstProjectTrace::OutputSpawn(const AActor* Spawner, const AActor* Spawned)
+{
+	UE_TRACE_LOG(FirstProject, Spawn, FirstProjectChannel)
+		<< Spawn.Cycle(FPlatformTime::Cycles64())
+		<< Spawn.SpawnerId(TraceId(Spawner))
+		<< Spawn.ActorId(TraceId(Spawned));
+
+	TRACE_COUNTER_INCREMENT(FirstProject_Spawns);
+}
+
+void FFirstProjectTrace::OutputSave(const AActor* Actor)
+{
+	UE_TRACE_LOG(FirstProject, SaveLoad, FirstProjectChannel)
+		<< SaveLoad.Cycle(FPlatformTime::Cycles64())
+		<< SaveLoad.ActorId(TraceId(Actor))
+		<< SaveLoad.bLoad(false);
+
+	TRACE_BOOKMARK(TEXT("SaveGame"));
+}
+
+void FFirstProjectTrace::OutputLoad(const AActor* Actor)
+{
+	UE_TRACE_LOG(FirstProject, SaveLoad, FirstProjectChannel)
+		<< SaveLoad.Cycle(FPlatformTime::Cycles64())
+		<< SaveLoad.ActorId(TraceId(Actor))
+		<< SaveLoad.bLoad(true);
+
+	TRACE_BOOKMARK(TEXT("LoadGame"));
+}
+
+void FFirstProjectTrace::OutputLevelTransition(FName FromLevel, FName ToLevel)
+{
+	const FString From = FromLevel.ToString();
+	const FString To = ToLevel.ToString();
+
+	UE_TRACE_LOG(FirstProject, LevelTransition, FirstProjectChannel)
+		<< LevelTransition.Cycle(FPlatformTime::Cycles64())
+		<< LevelTransition.FromLevel(*From, From.Len())
+		<< LevelTransition.ToLevel(*To, To.Len());
+
+	TRACE_BOOKMARK(TEXT("LevelTransition %s -> %s"), *From, *To);
+}
+
+#endif
@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Trace.h"
+
+/**
+ * Gameplay events for Unreal Insights. Compiled in wherever the engine has tracing
+ * (Development and Test), and only formatted when the channel is on:
+ *   -trace=cpu,frame,bookmark,counters,firstproject
+ * Every event is logged on the FirstProject channel. The rare ones (death, save/load,
+ * level transition) are also dropped as bookmarks so they line up with the frame in the
+ * timing view; damage, spawns and enemy state changes happen too often for that and are
+ * counted instead, as the FirstProject counter tracks.
+ */
+#if !defined(FIRSTPROJECT_TRACE_ENABLED)
+	#define FIRSTPROJECT_TRACE_ENABLED UE_TRACE_ENABLED
+#endif
+
+#if FIRSTPROJECT_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_EXTERN(FirstProjectChannel, FIRSTPROJECT_20_API);
+
+struct FIRSTPROJECT_20_API FFirstProjectTrace
+{
+	static void OutputEnemyState(const AActor* Enemy, uint8 State);
+	static void OutputDamage(const AActor* Victim, const AActor* Causer, float Amount);
+	static void OutputDeath(const AActor* Actor);
+	static void OutputSpawn(const AActor* Spawner, const AActor* Spawned);
+	static void OutputSave(const AActor* Actor);
+	static void OutputLoad(const AActor* Actor);
+	static void OutputLevelTransition(FName FromLevel, FName ToLevel);
+};
+
+#define FIRSTPROJECT_TRACE(Event, ...) \
+	do \
+	{ \
+		if (UE_TRACE_CHANNELEXPR_IS_ENABLED(FirstProjectChannel)) \
+		{ \
+			FFirstProjectTrace::Output##Event(__VA_ARGS__); \
+		} \
+	} while (0)
+
+#else
+
+#define FIRSTPROJECT_TRACE(Event, ...) do { } while (0)
+
+#endif
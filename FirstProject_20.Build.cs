@@ -13,6 +13,15 @@ public class FirstProject_20 : ModuleRules
 
 		PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
 
+		// Json for the benchmark result files, TraceLog for the Insights gameplay channel
+		PrivateDependencyModuleNames.AddRange(new string[] { "Json", "TraceLog" });
+
+		// NetCore for push model replication, ReplicationGraph for spatialized relevancy
+		PrivateDependencyModuleNames.AddRange(new string[] { "NetCore", "ReplicationGraph" });
+
+		// NavigationSystem for the flow field's navmesh probes
+		PrivateDependencyModuleNames.Add("NavigationSystem");
+
 		// Uncomment if you are using Slate UI
 		// PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
 		
@@ -4,3 +4,18 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, FirstProject_20, "FirstProject_20" );
+
+DEFINE_STAT(STAT_LiveEnemies);
+DEFINE_STAT(STAT_DamageEvents);
+DEFINE_STAT(STAT_Spawns);
+DEFINE_STAT(STAT_ClientConnections);
+DEFINE_STAT(STAT_MaxConnectionOutBytes);
+DEFINE_STAT(STAT_AvgConnectionOutBytes);
+
+CSV_DEFINE_CATEGORY_MODULE(FIRSTPROJECT_20_API, FirstProject, true);
+
+LLM_DEFINE_TAG(FirstProject_Enemies);
+LLM_DEFINE_TAG(FirstProject_Weapons);
+LLM_DEFINE_TAG(FirstProject_Items);
+LLM_DEFINE_TAG(FirstProject_SpawnVolumes);
+LLM_DEFINE_TAG(FirstProject_SaveData);
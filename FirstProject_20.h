@@ -3,4 +3,33 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "HAL/LowLevelMemTracker.h"
 
+/** "stat FirstProject" in the console, gameplay hot paths of this module */
+DECLARE_STATS_GROUP(TEXT("FirstProject"), STATGROUP_FirstProject, STATCAT_Advanced);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Enemies"), STAT_LiveEnemies, STATGROUP_FirstProject, FIRSTPROJECT_20_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Damage Events"), STAT_DamageEvents, STATGROUP_FirstProject, FIRSTPROJECT_20_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Spawns"), STAT_Spawns, STATGROUP_FirstProject, FIRSTPROJECT_20_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Client Connections"), STAT_ClientConnections, STATGROUP_FirstProject, FIRSTPROJECT_20_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Max Out Bytes/s per Connection"), STAT_MaxConnectionOutBytes, STATGROUP_FirstProject, FIRSTPROJECT_20_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Avg Out Bytes/s per Connection"), STAT_AvgConnectionOutBytes, STATGROUP_FirstProject, FIRSTPROJECT_20_API);
+
+/**
+ * Object channel of enemy capsules, so enemies can ignore each other and leave spacing to
+ * crowd avoidance. Declared in DefaultEngine.ini:
+ *   +DefaultChannelResponses=(Channel=ECC_GameTraceChannel1,DefaultResponse=ECR_Block,bTraceType=False,bStaticObject=False,Name="Enemy")
+ */
+#define ECC_Enemy ECC_GameTraceChannel1
+
+/** CSV profiler category, shows up in -csvCaptureFrames / csvprofile captures */
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(FIRSTPROJECT_20_API, FirstProject);
+
+/** Low-Level Memory Tracker tags, run with -llm and look at "stat LLM" or the LLM csv */
+LLM_DECLARE_TAG_API(FirstProject_Enemies, FIRSTPROJECT_20_API);
+LLM_DECLARE_TAG_API(FirstProject_Weapons, FIRSTPROJECT_20_API);
+LLM_DECLARE_TAG_API(FirstProject_Items, FIRSTPROJECT_20_API);
+LLM_DECLARE_TAG_API(FirstProject_SpawnVolumes, FIRSTPROJECT_20_API);
+LLM_DECLARE_TAG_API(FirstProject_SaveData, FIRSTPROJECT_20_API);
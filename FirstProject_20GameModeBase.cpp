@@ -1,7 +1,88 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "FirstProject_20GameModeBase.h"
+#include "FirstProject_20.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/CommandLine.h"
+#include "MainBotController.h"
+#include "LoadTestReport.h"
 
+// Sets default values
+AFirstProject_20GameModeBase::AFirstProject_20GameModeBase()
+{
+	// The net driver averages OutBytesPerSecond over a second, no need to look more often
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickInterval = 1.f;
 
+	ConnectionBudgetBytesPerSecond = 10000;
+	MaxConnectionOutBytesPerSecond = 0;
+	AvgConnectionOutBytesPerSecond = 0;
 
+	BotControllerClass = AMainBotController::StaticClass();
+}
 
+void AFirstProject_20GameModeBase::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("LoadTest")))
+	{
+		GetWorld()->SpawnActor<ALoadTestReport>();
+	}
+}
+
+APlayerController* AFirstProject_20GameModeBase::SpawnPlayerController(ENetRole InRemoteRole, const FString& Options)
+{
+	if (BotControllerClass && UGameplayStatics::HasOption(Options, TEXT("Bot")))
+	{
+		TSubclassOf<APlayerController> PlayerClass = PlayerControllerClass;
+		PlayerControllerClass = BotControllerClass;
+		APlayerController* Bot = Super::SpawnPlayerController(InRemoteRole, Options);
+		PlayerControllerClass = PlayerClass;
+		return Bot;
+	}
+	return Super::SpawnPlayerController(InRemoteRole, Options);
+}
+
+void AFirstProject_20GameModeBase::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UpdateBandwidthStats();
+}
+
+void AFirstProject_20GameModeBase::UpdateBandwidthStats()
+{
+	UNetDriver* NetDriver = GetNetDriver();
+	if (!NetDriver || !NetDriver->IsServer()) return;
+
+	int32 NumConnections = 0;
+	int32 TotalBytes = 0;
+	int32 MaxBytes = 0;
+	for (UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		if (!Connection) continue;
+
+		const int32 OutBytes = Connection->OutBytesPerSecond;
+		++NumConnections;
+		TotalBytes += OutBytes;
+		MaxBytes = FMath::Max(MaxBytes, OutBytes);
+
+		if (ConnectionBudgetBytesPerSecond > 0 && OutBytes > ConnectionBudgetBytesPerSecond)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Connection %s over budget: %d bytes/s (budget %d)"), *Connection->LowLevelGetRemoteAddress(), OutBytes, ConnectionBudgetBytesPerSecond);
+		}
+	}
+
+	MaxConnectionOutBytesPerSecond = MaxBytes;
+	AvgConnectionOutBytesPerSecond = NumConnections > 0 ? TotalBytes / NumConnections : 0;
+
+	SET_DWORD_STAT(STAT_ClientConnections, NumConnections);
+	SET_DWORD_STAT(STAT_MaxConnectionOutBytes, MaxConnectionOutBytesPerSecond);
+	SET_DWORD_STAT(STAT_AvgConnectionOutBytes, AvgConnectionOutBytesPerSecond);
+	CSV_CUSTOM_STAT(FirstProject, MaxConnectionOutBytes, MaxConnectionOutBytesPerSecond, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(FirstProject, AvgConnectionOutBytes, AvgConnectionOutBytesPerSecond, ECsvCustomStatOp::Set);
+}
@@ -14,7 +14,32 @@ class FIRSTPROJECT_20_API AFirstProject_20GameModeBase : public AGameModeBase
 {
 	GENERATED_BODY()
 	
-	
-	
+public:
+	// Sets default values
+	AFirstProject_20GameModeBase();
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual void BeginPlay() override;
+
+	/** Controller for clients that join with ?Bot, see AMainBotController */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Load Test")
+	TSubclassOf<class APlayerController> BotControllerClass;
+
+	/** Per connection outgoing budget, connections above it get logged */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Network")
+	int32 ConnectionBudgetBytesPerSecond;
+
+	/** Refreshed every tick interval from the net driver */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Network")
+	int32 MaxConnectionOutBytesPerSecond;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Network")
+	int32 AvgConnectionOutBytesPerSecond;
+
+protected:
+	virtual APlayerController* SpawnPlayerController(ENetRole InRemoteRole, const FString& Options) override;
+
+	void UpdateBandwidthStats();
 	
 };
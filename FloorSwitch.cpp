@@ -1,9 +1,14 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "FloorSwitch.h"
+#include "FirstProject_20.h"
 #include "Components/BoxComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "TimerManager.h" 
+#include "AI/NavigationSystemBase.h"
+#include "NavAreas/NavArea_Default.h"
+#include "NavAreas/NavArea_Null.h"
+#include "Net/UnrealNetwork.h"
 
 // Sets default values
 AFloorSwitch::AFloorSwitch()
@@ -18,6 +23,7 @@ AFloorSwitch::AFloorSwitch()
 	TriggerBox->SetCollisionObjectType(ECollisionChannel::ECC_WorldStatic);
 	TriggerBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
 	TriggerBox->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Overlap);
+	TriggerBox->SetCollisionResponseToChannel(ECC_Enemy, ECollisionResponse::ECR_Overlap);
 
 	TriggerBox->SetBoxExtent(FVector(62.f, 62.f, 32.f));
 
@@ -26,9 +32,42 @@ AFloorSwitch::AFloorSwitch()
 
 	Door = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Door"));
 	Door->SetupAttachment(GetRootComponent());
+	// A moving mesh would dirty navmesh tiles every frame it moves, DoorNavArea stands in for it
+	Door->SetCanEverAffectNavigation(false);
+
+	DoorNavArea = CreateDefaultSubobject<UBoxComponent>(TEXT("DoorNavArea"));
+	DoorNavArea->SetupAttachment(GetRootComponent());
+	DoorNavArea->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	DoorNavArea->SetCanEverAffectNavigation(true);
+	DoorNavArea->bDynamicObstacle = true;
+	DoorNavArea->AreaClass = UNavArea_Null::StaticClass();
 
 	SwitchTime = 1.5f;
+	DoorOpenHeight = 450.f;
+	bDoorRaising = false;
 	bCharacterOnSwitch = false;
+
+	// Dormant until someone steps on it
+	bReplicates = true;
+	NetDormancy = DORM_Initial;
+}
+
+void AFloorSwitch::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AFloorSwitch, bCharacterOnSwitch);
+}
+
+void AFloorSwitch::SetCharacterOnSwitch(bool bOnSwitch)
+{
+	if (bCharacterOnSwitch == bOnSwitch) return;
+
+	bCharacterOnSwitch = bOnSwitch;
+	if (HasAuthority())
+	{
+		FlushNetDormancy();
+	}
 }
 
 // Called when the game starts or when spawned
@@ -41,6 +80,13 @@ void AFloorSwitch::BeginPlay()
 
 	InitialDoorLocation = Door->GetComponentLocation();
 	InitialSwitchLocation = FloorSwitch->GetComponentLocation();
+
+	// Fit the modifier to the closed door once, from then on only its area class changes.
+	// Bounds are in world space, the box extent is scaled by the actor's scale on top
+	const FVector Scale = DoorNavArea->GetComponentScale().GetAbs().ComponentMax(FVector(KINDA_SMALL_NUMBER));
+	DoorNavArea->SetWorldLocation(Door->Bounds.Origin);
+	DoorNavArea->SetBoxExtent(Door->Bounds.BoxExtent / Scale, false);
+	FNavigationSystem::UpdateComponentData(*DoorNavArea);
 }
 
 // Called every frame
@@ -53,9 +99,10 @@ void AFloorSwitch::Tick(float DeltaTime)
 void AFloorSwitch::OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult & SweepResult)
 {
 	UE_LOG(LogTemp, Warning, TEXT("Overlap Begin."));
-	if (!bCharacterOnSwitch)
-		bCharacterOnSwitch = true;
+	SetCharacterOnSwitch(true);
 
+	// Still blocked until the door is all the way up, see UpdateDoorLocation
+	bDoorRaising = true;
 	RaiseDoor();
 	LowerFloorSwitch();
 }
@@ -63,8 +110,7 @@ void AFloorSwitch::OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AAct
 void AFloorSwitch::OnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
 {
 	UE_LOG(LogTemp, Warning, TEXT("Overlap End."));
-	if (bCharacterOnSwitch)
-		bCharacterOnSwitch = false;
+	SetCharacterOnSwitch(false);
 
 	GetWorldTimerManager().SetTimer(SwitchHandle, this, &AFloorSwitch::CloseDoor, SwitchTime);
 }
@@ -74,6 +120,19 @@ void AFloorSwitch::UpdateDoorLocation(float Z)
 	FVector NewLocation = InitialDoorLocation;
 	NewLocation.Z += Z;
 	Door->SetWorldLocation(NewLocation);
+
+	if (bDoorRaising && Z >= DoorOpenHeight - 1.f)
+	{
+		OnDoorRaised();
+	}
+}
+
+void AFloorSwitch::OnDoorRaised()
+{
+	if (bDoorRaising)
+	{
+		SetDoorNavigable(true);
+	}
 }
 
 void AFloorSwitch::UpdateFloorSwitchLocation(float Z)
@@ -87,7 +146,20 @@ void AFloorSwitch::CloseDoor()
 {
 	if (!bCharacterOnSwitch)
 	{
+		// Blocked as soon as it starts coming down
+		bDoorRaising = false;
+		SetDoorNavigable(false);
 		LowerDoor();
 		RaiseFloorSwitch();
 	}
+}
+
+void AFloorSwitch::SetDoorNavigable(bool bNavigable)
+{
+	TSubclassOf<UNavAreaBase> NewArea = bNavigable ? UNavArea_Default::StaticClass() : UNavArea_Null::StaticClass();
+	if (DoorNavArea->AreaClass != NewArea)
+	{
+		DoorNavArea->AreaClass = NewArea;
+		FNavigationSystem::UpdateComponentData(*DoorNavArea);
+	}
 }
\ No newline at end of file
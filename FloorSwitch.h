@@ -27,6 +27,13 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Floor Switch")
 	class UStaticMeshComponent* Door;
 
+	/**
+	 * Covers the closed door on the navmesh, fitted to the door in BeginPlay. The door itself
+	 * doesn't affect navigation; opening and closing only swap this box's area class.
+	 */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Floor Switch")
+	class UBoxComponent* DoorNavArea;
+
 	/** Initial location for the door */
 	UPROPERTY(BlueprintReadWrite, Category= "Floor Switch")
 	FVector InitialDoorLocation;
@@ -40,10 +47,26 @@ public:
 	UPROPERTY(EditAnywhere ,BlueprintReadWrite, Category = "Floor Switch")
 	float SwitchTime;
 
+	/** Z offset UpdateDoorLocation reaches when the door is all the way up, only then can enemies path through */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Floor Switch")
+	float DoorOpenHeight;
+
+	/** Between stepping on the switch and the door closing again */
+	bool bDoorRaising;
+
+	UPROPERTY(Replicated)
 	bool bCharacterOnSwitch;
 
+	/** Sets bCharacterOnSwitch and wakes the switch so the change replicates */
+	void SetCharacterOnSwitch(bool bOnSwitch);
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	void CloseDoor();
 
+	/** Passable or blocked for pathing, no navmesh rebuild */
+	void SetDoorNavigable(bool bNavigable);
+
 
 protected:
 	// Called when the game starts or when spawned
@@ -74,6 +97,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Floor Switch")
 	void UpdateDoorLocation(float Z);
 
+	/** For raise timelines that don't end on DoorOpenHeight, call when the door is up */
+	UFUNCTION(BlueprintCallable, Category = "Floor Switch")
+	void OnDoorRaised();
+
 	UFUNCTION(BlueprintCallable, Category = "Floor Switch")
 	void UpdateFloorSwitchLocation(float Z);
 
@@ -0,0 +1,312 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FlowFieldSubsystem.h"
+#include "FirstProject_20.h"
+#include "Engine/World.h"
+#include "NavigationSystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("FlowField Probe"), STAT_FlowFieldProbe, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("FlowField Integrate"), STAT_FlowFieldIntegrate, STATGROUP_FirstProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("FlowField Samples"), STAT_FlowFieldSamples, STATGROUP_FirstProject);
+
+namespace
+{
+	// Neighbours in the order the direction index refers to: the four sides, then the diagonals
+	const FIntPoint NeighbourOffsets[8] =
+	{
+		FIntPoint(1, 0), FIntPoint(-1, 0), FIntPoint(0, 1), FIntPoint(0, -1),
+		FIntPoint(1, 1), FIntPoint(1, -1), FIntPoint(-1, 1), FIntPoint(-1, -1)
+	};
+
+	const float Diagonal = 0.70710678f;
+
+	const FVector NeighbourDirections[8] =
+	{
+		FVector(1.f, 0.f, 0.f), FVector(-1.f, 0.f, 0.f), FVector(0.f, 1.f, 0.f), FVector(0.f, -1.f, 0.f),
+		FVector(Diagonal, Diagonal, 0.f), FVector(Diagonal, -Diagonal, 0.f),
+		FVector(-Diagonal, Diagonal, 0.f), FVector(-Diagonal, -Diagonal, 0.f)
+	};
+}
+
+UFlowFieldSubsystem::UFlowFieldSubsystem()
+{
+	GridSize = 64;
+	CellSize = 100.f;
+	ProbeBudget = 256;
+	MaxStepHeight = 60.f;
+	FieldLifetime = 5.f;
+}
+
+void UFlowFieldSubsystem::Deinitialize()
+{
+	Fields.Empty();
+
+	Super::Deinitialize();
+}
+
+FIntPoint UFlowFieldSubsystem::WorldToCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+UFlowFieldSubsystem::FFlowField* UFlowFieldSubsystem::FindOrAddField(const AActor* Goal)
+{
+	for (FFlowField& Field : Fields)
+	{
+		if (Field.Goal.Get() == Goal)
+		{
+			return &Field;
+		}
+	}
+
+	LLM_SCOPE_BYTAG(FirstProject_Enemies);
+
+	const int32 NumCells = GridSize * GridSize;
+	FFlowField& Field = Fields.AddDefaulted_GetRef();
+	Field.Goal = Goal;
+	Field.States.SetNumZeroed(NumCells);
+	Field.Heights.SetNumZeroed(NumCells);
+	Field.Distances.Init(Unreached, NumCells);
+	Field.Directions.Init(NoDirection, NumCells);
+	Field.ProbeCursor = 0;
+	Field.UnprobedCount = NumCells;
+	Field.bNeedsIntegration = true;
+
+	Field.GoalCell = WorldToCell(Goal->GetActorLocation());
+	Field.Origin = Field.GoalCell - FIntPoint(GridSize / 2, GridSize / 2);
+	return &Field;
+}
+
+bool UFlowFieldSubsystem::SampleDirection(const AActor* Goal, const FVector& Location, FVector& OutDirection)
+{
+	if (Goal == nullptr)
+		return false;
+
+	INC_DWORD_STAT(STAT_FlowFieldSamples);
+
+	FFlowField* Field = FindOrAddField(Goal);
+	Field->LastSampleTime = GetWorld()->GetTimeSeconds();
+
+	const FIntPoint Cell = WorldToCell(Location) - Field->Origin;
+	if (Cell.X < 0 || Cell.Y < 0 || Cell.X >= GridSize || Cell.Y >= GridSize)
+		return false;
+
+	const uint8 Direction = Field->Directions[Cell.Y * GridSize + Cell.X];
+	if (Direction == NoDirection)
+		return false;
+
+	OutDirection = NeighbourDirections[Direction];
+	return true;
+}
+
+void UFlowFieldSubsystem::Tick(float DeltaTime)
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	Fields.RemoveAllSwap([Now, this](const FFlowField& Field) { return !Field.Goal.IsValid() || Now - Field.LastSampleTime > FieldLifetime; });
+
+	int32 Budget = ProbeBudget;
+	for (FFlowField& Field : Fields)
+	{
+		const FIntPoint GoalCell = WorldToCell(Field.Goal->GetActorLocation());
+		if (GoalCell != Field.GoalCell)
+		{
+			Field.GoalCell = GoalCell;
+			Field.bNeedsIntegration = true;
+
+			// Keep a quarter of the grid between the goal and the edge
+			const FIntPoint Local = GoalCell - Field.Origin;
+			const int32 Margin = GridSize / 4;
+			if (Local.X < Margin || Local.Y < Margin || Local.X >= GridSize - Margin || Local.Y >= GridSize - Margin)
+			{
+				Recenter(Field, GoalCell);
+			}
+		}
+
+		if (Budget > 0 && Field.UnprobedCount > 0)
+		{
+			Budget -= ProbeCells(Field, Budget);
+		}
+
+		if (Field.bNeedsIntegration)
+		{
+			Integrate(Field);
+		}
+	}
+}
+
+TStatId UFlowFieldSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFlowFieldSubsystem, STATGROUP_Tickables);
+}
+
+void UFlowFieldSubsystem::Recenter(FFlowField& Field, const FIntPoint& Center)
+{
+	const FIntPoint NewOrigin = Center - FIntPoint(GridSize / 2, GridSize / 2);
+	const FIntPoint Shift = NewOrigin - Field.Origin;
+
+	TArray<uint8> States;
+	TArray<float> Heights;
+	States.SetNumZeroed(GridSize * GridSize);
+	Heights.SetNumZeroed(GridSize * GridSize);
+
+	int32 UnprobedCount = 0;
+	for (int32 Y = 0; Y < GridSize; ++Y)
+	{
+		for (int32 X = 0; X < GridSize; ++X)
+		{
+			const int32 OldX = X + Shift.X;
+			const int32 OldY = Y + Shift.Y;
+			const int32 Index = Y * GridSize + X;
+			if (OldX >= 0 && OldY >= 0 && OldX < GridSize && OldY < GridSize)
+			{
+				States[Index] = Field.States[OldY * GridSize + OldX];
+				Heights[Index] = Field.Heights[OldY * GridSize + OldX];
+			}
+			if (States[Index] == Unprobed)
+			{
+				++UnprobedCount;
+			}
+		}
+	}
+
+	Field.Origin = NewOrigin;
+	Field.States = MoveTemp(States);
+	Field.Heights = MoveTemp(Heights);
+	Field.UnprobedCount = UnprobedCount;
+	Field.ProbeCursor = 0;
+	Field.bNeedsIntegration = true;
+}
+
+int32 UFlowFieldSubsystem::ProbeCells(FFlowField& Field, int32 Budget)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlowFieldProbe);
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if (NavSys == nullptr)
+		return 0;
+
+	const int32 NumCells = GridSize * GridSize;
+	const float GoalZ = Field.Goal->GetActorLocation().Z;
+	const FVector Extent(CellSize * 0.5f, CellSize * 0.5f, 500.f);
+
+	int32 Used = 0;
+	for (int32 Visited = 0; Visited < NumCells && Used < Budget; ++Visited)
+	{
+		const int32 Index = Field.ProbeCursor;
+		Field.ProbeCursor = (Field.ProbeCursor + 1) % NumCells;
+		if (Field.States[Index] != Unprobed)
+			continue;
+
+		const FIntPoint Cell = Field.Origin + FIntPoint(Index % GridSize, Index / GridSize);
+		const FVector Center((Cell.X + 0.5f) * CellSize, (Cell.Y + 0.5f) * CellSize, GoalZ);
+
+		FNavLocation NavLocation;
+		if (NavSys->ProjectPointToNavigation(Center, NavLocation, Extent))
+		{
+			Field.States[Index] = Walkable;
+			Field.Heights[Index] = NavLocation.Location.Z;
+		}
+		else
+		{
+			Field.States[Index] = Blocked;
+		}
+
+		--Field.UnprobedCount;
+		++Used;
+	}
+
+	if (Used > 0)
+	{
+		Field.bNeedsIntegration = true;
+	}
+	return Used;
+}
+
+void UFlowFieldSubsystem::Integrate(FFlowField& Field)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FlowFieldIntegrate);
+
+	Field.bNeedsIntegration = false;
+
+	const int32 NumCells = GridSize * GridSize;
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		Field.Distances[Index] = Unreached;
+		Field.Directions[Index] = NoDirection;
+	}
+
+	const FIntPoint GoalLocal = Field.GoalCell - Field.Origin;
+	if (GoalLocal.X < 0 || GoalLocal.Y < 0 || GoalLocal.X >= GridSize || GoalLocal.Y >= GridSize)
+		return;
+
+	// The goal's own cell counts as walkable for this pass only, the player can be standing
+	// on an edge the probe missed. The probed state stays as it was for the next goal
+	const int32 GoalIndex = GoalLocal.Y * GridSize + GoalLocal.X;
+	const float GoalHeight = Field.States[GoalIndex] == Walkable ? Field.Heights[GoalIndex] : Field.Goal->GetActorLocation().Z;
+
+	auto IsConnected = [&](int32 From, int32 To)
+	{
+		const float FromHeight = From == GoalIndex ? GoalHeight : Field.Heights[From];
+		return Field.States[To] == Walkable && FMath::Abs(Field.Heights[To] - FromHeight) <= MaxStepHeight;
+	};
+
+	// Breadth first over the four sides
+	TArray<int32> Queue;
+	Queue.Reserve(NumCells);
+	Field.Distances[GoalIndex] = 0;
+	Queue.Add(GoalIndex);
+
+	for (int32 Head = 0; Head < Queue.Num(); ++Head)
+	{
+		const int32 Index = Queue[Head];
+		const int32 X = Index % GridSize;
+		const int32 Y = Index / GridSize;
+		for (int32 Side = 0; Side < 4; ++Side)
+		{
+			const int32 NX = X + NeighbourOffsets[Side].X;
+			const int32 NY = Y + NeighbourOffsets[Side].Y;
+			if (NX < 0 || NY < 0 || NX >= GridSize || NY >= GridSize)
+				continue;
+
+			const int32 Next = NY * GridSize + NX;
+			if (Field.Distances[Next] == Unreached && IsConnected(Index, Next))
+			{
+				Field.Distances[Next] = Field.Distances[Index] + 1;
+				Queue.Add(Next);
+			}
+		}
+	}
+
+	// Point every reached cell at its closest neighbour, diagonals only when both sides are open
+	for (int32 Index : Queue)
+	{
+		if (Index == GoalIndex)
+			continue;
+
+		const int32 X = Index % GridSize;
+		const int32 Y = Index / GridSize;
+		uint16 Best = Field.Distances[Index];
+		for (int32 Dir = 0; Dir < 8; ++Dir)
+		{
+			const int32 NX = X + NeighbourOffsets[Dir].X;
+			const int32 NY = Y + NeighbourOffsets[Dir].Y;
+			if (NX < 0 || NY < 0 || NX >= GridSize || NY >= GridSize)
+				continue;
+
+			const int32 Next = NY * GridSize + NX;
+			if (Dir >= 4)
+			{
+				const int32 SideX = Y * GridSize + NX;
+				const int32 SideY = NY * GridSize + X;
+				if (Field.Distances[SideX] == Unreached || Field.Distances[SideY] == Unreached)
+					continue;
+			}
+
+			if (Field.Distances[Next] < Best)
+			{
+				Best = Field.Distances[Next];
+				Field.Directions[Index] = (uint8)Dir;
+			}
+		}
+	}
+}
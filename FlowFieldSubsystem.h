@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "FlowFieldSubsystem.generated.h"
+
+/**
+ * One flow field per chased goal (the player), shared by every enemy chasing it.
+ *
+ * A field is a GridSize x GridSize grid of CellSize cells, snapped to the world grid and
+ * centred on the goal. Cells are probed against the navmesh a few hundred per frame; when
+ * the goal walks off centre the grid shifts and keeps what it already probed. The
+ * integration field is a breadth first search out from the goal's cell, redone only when
+ * the goal changes cell or new cells were probed, and each cell stores the direction to
+ * its best neighbour. Sampling a direction is a cell lookup, whatever the number of chasers.
+ */
+UCLASS(Config = Game)
+class FIRSTPROJECT_20_API UFlowFieldSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UFlowFieldSubsystem();
+
+	/** Cells per side */
+	UPROPERTY(Config)
+	int32 GridSize;
+
+	UPROPERTY(Config)
+	float CellSize;
+
+	/** Navmesh probes per frame, shared by all fields */
+	UPROPERTY(Config)
+	int32 ProbeBudget;
+
+	/** Height difference between neighbouring cells that still counts as connected */
+	UPROPERTY(Config)
+	float MaxStepHeight;
+
+	/** Fields nobody sampled for this long are dropped */
+	UPROPERTY(Config)
+	float FieldLifetime;
+
+	/**
+	 * Direction to steer from Location to reach Goal, flat and normalized.
+	 * False when there's no field data there yet, or Location is already in the goal's cell.
+	 */
+	bool SampleDirection(const AActor* Goal, const FVector& Location, FVector& OutDirection);
+
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return Fields.Num() > 0; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+protected:
+
+	enum ECellState : uint8
+	{
+		Unprobed,
+		Blocked,
+		Walkable
+	};
+
+	static constexpr uint8 NoDirection = 0xFF;
+	static constexpr uint16 Unreached = 0xFFFF;
+
+	struct FFlowField
+	{
+		TWeakObjectPtr<const AActor> Goal;
+
+		/** World cell of the grid's (0, 0) corner */
+		FIntPoint Origin;
+		FIntPoint GoalCell;
+
+		TArray<uint8> States;
+		TArray<float> Heights;
+		TArray<uint16> Distances;
+		TArray<uint8> Directions;
+
+		/** Next cell to look at when probing */
+		int32 ProbeCursor;
+		int32 UnprobedCount;
+
+		bool bNeedsIntegration;
+		float LastSampleTime;
+	};
+
+	FFlowField* FindOrAddField(const AActor* Goal);
+
+	FIntPoint WorldToCell(const FVector& Location) const;
+
+	/** Move the grid so Center is in the middle, keeping cells both grids share */
+	void Recenter(FFlowField& Field, const FIntPoint& Center);
+
+	/** Probe up to Budget cells, returns how many it used */
+	int32 ProbeCells(FFlowField& Field, int32 Budget);
+
+	void Integrate(FFlowField& Field);
+
+	TArray<FFlowField> Fields;
+};
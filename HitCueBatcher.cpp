@@ -0,0 +1,269 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HitCueBatcher.h"
+#include "FirstProject_20.h"
+#include "FirstProjectCosmetics.h"
+#include "MainPlayerController.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Particles/ParticleSystem.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "Sound/SoundBase.h"
+#include "Net/UnrealNetwork.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hit Cues Queued"), STAT_HitCuesQueued, STATGROUP_FirstProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hit Cue Batches"), STAT_HitCueBatches, STATGROUP_FirstProject);
+
+namespace
+{
+	/** How long a predicted cue waits for the server's copy, and how close that copy has to be */
+	const float PredictedCueLifetime = 1.f;
+	const float PredictedCueMatchDistance = 100.f;
+
+	/** One batcher per world, PIE runs several worlds side by side */
+	TMap<TWeakObjectPtr<UWorld>, TWeakObjectPtr<AHitCueBatcher>> WorldBatchers;
+}
+
+// Sets default values
+AHitCueBatcher::AHitCueBatcher()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	NetUpdateFrequency = 1.f;
+
+	ParticlePoolSize = 32;
+	MaxCuesPerBatch = 64;
+	CueRelevancyDistance = 6000.f;
+	NextPoolIndex = 0;
+}
+
+void AHitCueBatcher::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AHitCueBatcher, CueEffects);
+}
+
+AHitCueBatcher* AHitCueBatcher::Get(const AActor* Source)
+{
+	UWorld* World = Source ? Source->GetWorld() : nullptr;
+	if (!World) return nullptr;
+
+	TWeakObjectPtr<AHitCueBatcher>& Cached = WorldBatchers.FindOrAdd(World);
+	if (Cached.IsValid())
+	{
+		return Cached.Get();
+	}
+
+	for (TActorIterator<AHitCueBatcher> It(World); It; ++It)
+	{
+		Cached = *It;
+		return *It;
+	}
+
+	if (World->GetNetMode() != NM_Client)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		Cached = World->SpawnActor<AHitCueBatcher>(SpawnParams);
+		return Cached.Get();
+	}
+	return nullptr;
+}
+
+void AHitCueBatcher::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	WorldBatchers.Remove(GetWorld());
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AHitCueBatcher::QueueHitCue(const AActor* Source, UParticleSystem* Particles, USoundBase* Sound, const FVector& Location, EPhysicalSurface Surface)
+{
+	if (!Source || !Source->HasAuthority() || (!Particles && !Sound)) return;
+
+	AHitCueBatcher* Batcher = Get(Source);
+	if (!Batcher) return;
+
+	const int32 CueId = Batcher->FindOrAddCue(Particles, Sound);
+	if (CueId == INDEX_NONE) return;
+
+	FHitCue& Cue = Batcher->PendingCues.AddDefaulted_GetRef();
+	Cue.Location = Location;
+	Cue.CueId = (uint8)CueId;
+	Cue.Surface = Surface;
+	INC_DWORD_STAT(STAT_HitCuesQueued);
+}
+
+void AHitCueBatcher::PlayPredictedHitCue(const AActor* Source, UParticleSystem* Particles, USoundBase* Sound, const FVector& Location)
+{
+#if FIRSTPROJECT_WITH_COSMETICS
+	// Not replicated to us yet, there's nowhere to remember the prediction so leave it to the server's copy
+	AHitCueBatcher* Batcher = Get(Source);
+	if (!Batcher) return;
+
+	FHitCueEffect Effect;
+	Effect.Particles = Particles;
+	Effect.Sound = Sound;
+	Batcher->PlayCue(Effect, Location, SurfaceType_Default);
+
+	FPredictedHitCue& Predicted = Batcher->PredictedCues.AddDefaulted_GetRef();
+	Predicted.Location = Location;
+	Predicted.Particles = Particles;
+	Predicted.Time = Batcher->GetWorld()->GetTimeSeconds();
+#endif
+}
+
+int32 AHitCueBatcher::FindOrAddCue(UParticleSystem* Particles, USoundBase* Sound)
+{
+	for (int32 Index = 0; Index < CueEffects.Num(); ++Index)
+	{
+		if (CueEffects[Index].Particles == Particles && CueEffects[Index].Sound == Sound)
+		{
+			return Index;
+		}
+	}
+
+	if (CueEffects.Num() > MAX_uint8)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Out of hit cue ids, %s not sent"), Particles ? *Particles->GetName() : TEXT("None"));
+		return INDEX_NONE;
+	}
+
+	FHitCueEffect& Effect = CueEffects.AddDefaulted_GetRef();
+	Effect.Particles = Particles;
+	Effect.Sound = Sound;
+
+	// The table only changes when a new kind of hit shows up, push it out right away
+	ForceNetUpdate();
+	return CueEffects.Num() - 1;
+}
+
+void AHitCueBatcher::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (PendingCues.Num() > 0)
+	{
+		SendPendingCues();
+		PendingCues.Reset();
+	}
+
+	if (PredictedCues.Num() > 0)
+	{
+		const float Now = GetWorld()->GetTimeSeconds();
+		PredictedCues.RemoveAllSwap([Now](const FPredictedHitCue& Predicted) { return Now - Predicted.Time > PredictedCueLifetime; });
+	}
+}
+
+void AHitCueBatcher::SendPendingCues()
+{
+	const float MaxDistSquared = FMath::Square(CueRelevancyDistance);
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		AMainPlayerController* PlayerController = Cast<AMainPlayerController>(It->Get());
+		if (!PlayerController) continue;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		RelevantCues.Reset();
+		for (const FHitCue& Cue : PendingCues)
+		{
+			if (FVector::DistSquared(Cue.Location, ViewLocation) <= MaxDistSquared)
+			{
+				RelevantCues.Add(Cue);
+			}
+		}
+
+		// Over the cap, keep the hits closest to this player's view
+		if (MaxCuesPerBatch > 0 && RelevantCues.Num() > MaxCuesPerBatch)
+		{
+			RelevantCues.Sort([&ViewLocation](const FHitCue& A, const FHitCue& B)
+			{
+				return FVector::DistSquared(A.Location, ViewLocation) < FVector::DistSquared(B.Location, ViewLocation);
+			});
+			RelevantCues.SetNum(MaxCuesPerBatch, false);
+		}
+
+		if (RelevantCues.Num() > 0)
+		{
+			PlayerController->ClientHitCues(RelevantCues);
+			INC_DWORD_STAT(STAT_HitCueBatches);
+		}
+	}
+}
+
+void AHitCueBatcher::ReceiveHitCues(const TArray<FHitCue>& Cues)
+{
+#if FIRSTPROJECT_WITH_COSMETICS
+	if (!FFirstProjectCosmetics::ShouldPlayCosmetics(this)) return;
+
+	for (const FHitCue& Cue : Cues)
+	{
+		// The table may be a net update behind the first batch that uses a new id
+		if (!CueEffects.IsValidIndex(Cue.CueId)) continue;
+
+		const FHitCueEffect& Effect = CueEffects[Cue.CueId];
+
+		const int32 PredictedIndex = PredictedCues.IndexOfByPredicate([&](const FPredictedHitCue& Predicted)
+		{
+			return Predicted.Particles == Effect.Particles && FVector::DistSquared(Predicted.Location, Cue.Location) < FMath::Square(PredictedCueMatchDistance);
+		});
+		if (PredictedIndex != INDEX_NONE)
+		{
+			PredictedCues.RemoveAtSwap(PredictedIndex);
+			continue;
+		}
+
+		PlayCue(Effect, Cue.Location, Cue.Surface);
+	}
+#endif
+}
+
+void AHitCueBatcher::PlayCue(const FHitCueEffect& Effect, const FVector& Location, EPhysicalSurface Surface)
+{
+#if FIRSTPROJECT_WITH_COSMETICS
+	SpawnPooledParticles(Effect.Particles, Location);
+
+	if (UParticleSystem** SurfaceEffect = SurfaceParticles.Find(Surface))
+	{
+		SpawnPooledParticles(*SurfaceEffect, Location);
+	}
+
+	FFirstProjectCosmetics::PlaySound2D(this, Effect.Sound);
+#endif
+}
+
+void AHitCueBatcher::SpawnPooledParticles(UParticleSystem* Particles, const FVector& Location)
+{
+#if FIRSTPROJECT_WITH_COSMETICS
+	if (!Particles || ParticlePoolSize <= 0) return;
+
+	UParticleSystemComponent* Component = nullptr;
+	if (ParticlePool.Num() < ParticlePoolSize)
+	{
+		Component = NewObject<UParticleSystemComponent>(this);
+		Component->bAutoActivate = false;
+		Component->bAutoDestroy = false;
+		Component->SetAbsolute(true, true, true);
+		Component->RegisterComponent();
+		ParticlePool.Add(Component);
+	}
+	else
+	{
+		// Round robin, when the pool is busy the oldest effect gets cut short
+		Component = ParticlePool[NextPoolIndex];
+		NextPoolIndex = (NextPoolIndex + 1) % ParticlePool.Num();
+	}
+
+	Component->SetTemplate(Particles);
+	Component->SetWorldLocation(Location);
+	Component->ActivateSystem(true);
+#endif
+}
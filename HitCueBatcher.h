@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Info.h"
+#include "Engine/NetSerialization.h"
+#include "Chaos/ChaosEngineInterface.h"
+#include "HitCueBatcher.generated.h"
+
+/** Particles + sound a cue id stands for */
+USTRUCT()
+struct FHitCueEffect
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	class UParticleSystem* Particles = nullptr;
+
+	UPROPERTY()
+	class USoundBase* Sound = nullptr;
+};
+
+/** One hit as it goes over the network, 8 bytes or so after quantization */
+USTRUCT()
+struct FHitCue
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize Location;
+
+	/** Index into AHitCueBatcher::CueEffects */
+	UPROPERTY()
+	uint8 CueId = 0;
+
+	UPROPERTY()
+	TEnumAsByte<EPhysicalSurface> Surface = SurfaceType_Default;
+};
+
+/**
+ * Collects the cosmetic side of every hit during a server frame and sends them in one
+ * unreliable client RPC per player at the end of the frame, instead of an RPC per hit.
+ * Each player only gets the hits near their view. Clients fan the batch out into a
+ * small pool of particle components.
+ *
+ * Cue ids are handed out on the server the first time a particles/sound pair is used
+ * and the table replicates with the batcher, so new enemy types need no setup.
+ */
+UCLASS()
+class FIRSTPROJECT_20_API AHitCueBatcher : public AInfo
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AHitCueBatcher();
+
+	/** Server: queue a hit for this frame's batch. Does nothing on clients */
+	static void QueueHitCue(const AActor* Source, class UParticleSystem* Particles, class USoundBase* Sound, const FVector& Location, EPhysicalSurface Surface = SurfaceType_Default);
+
+	/** Owning client: play our own hit right away, the server's copy of it is skipped when it arrives */
+	static void PlayPredictedHitCue(const AActor* Source, class UParticleSystem* Particles, class USoundBase* Sound, const FVector& Location);
+
+	/** The world's batcher, spawned on the server the first time it's needed */
+	static AHitCueBatcher* Get(const AActor* Source);
+
+	/** Client: play a batch the server sent to our player controller */
+	void ReceiveHitCues(const TArray<FHitCue>& Cues);
+
+	/** Extra impact particles by physical surface, layered on the cue's own */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Hit Cues")
+	TMap<TEnumAsByte<EPhysicalSurface>, class UParticleSystem*> SurfaceParticles;
+
+	/** Particle components kept around for reuse on each client */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Hit Cues")
+	int32 ParticlePoolSize;
+
+	/** Most cues one player gets in a frame, the furthest of their relevant cues are dropped. Nobody can tell in a brawl that size */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Hit Cues")
+	int32 MaxCuesPerBatch;
+
+	/** Hits further than this from a player's view aren't sent to that player */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Hit Cues")
+	float CueRelevancyDistance;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+protected:
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Server: send each player the pending cues near their view */
+	void SendPendingCues();
+
+	/** Cue id of the pair, registering it if new. INDEX_NONE once ids run out */
+	int32 FindOrAddCue(class UParticleSystem* Particles, class USoundBase* Sound);
+
+	void PlayCue(const FHitCueEffect& Effect, const FVector& Location, EPhysicalSurface Surface);
+	void SpawnPooledParticles(class UParticleSystem* Particles, const FVector& Location);
+
+	UPROPERTY(Replicated)
+	TArray<FHitCueEffect> CueEffects;
+
+	TArray<FHitCue> PendingCues;
+
+	/** Reused per player while filtering PendingCues */
+	TArray<FHitCue> RelevantCues;
+
+	UPROPERTY(Transient)
+	TArray<class UParticleSystemComponent*> ParticlePool;
+
+	int32 NextPoolIndex;
+
+	struct FPredictedHitCue
+	{
+		FVector Location;
+		UParticleSystem* Particles;
+		float Time;
+	};
+
+	TArray<FPredictedHitCue> PredictedCues;
+};
@@ -0,0 +1,185 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HitRewindSubsystem.h"
+#include "FirstProject_20.h"
+#include "Enemy.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+
+DECLARE_CYCLE_STAT(TEXT("HitRewind Record"), STAT_HitRewindRecord, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("HitRewind Validate"), STAT_HitRewindValidate, STATGROUP_FirstProject);
+
+UHitRewindSubsystem::UHitRewindSubsystem()
+{
+	NewestFrame = 0;
+	NumFrames = 0;
+	NumRegistered = 0;
+}
+
+void UHitRewindSubsystem::Deinitialize()
+{
+	Locations.Empty();
+	Shapes.Empty();
+	Targets.Empty();
+	FreeSlots.Empty();
+	NumRegistered = 0;
+
+	Super::Deinitialize();
+}
+
+int32 UHitRewindSubsystem::RegisterTarget(AEnemy* Enemy)
+{
+	if (!Enemy || !Enemy->HasAuthority() || GetWorld()->GetNetMode() == NM_Standalone) return INDEX_NONE;
+
+	return AddTarget(Enemy);
+}
+
+int32 UHitRewindSubsystem::AddTarget(AEnemy* Enemy)
+{
+	if (Targets.Num() == 0)
+	{
+		LLM_SCOPE_BYTAG(FirstProject_Enemies);
+
+		Locations.SetNumZeroed(MaxTargets * HistoryLength);
+		Shapes.SetNumZeroed(MaxTargets);
+		Targets.SetNum(MaxTargets);
+		FreeSlots.Reserve(MaxTargets);
+		for (int32 Slot = MaxTargets - 1; Slot >= 0; --Slot)
+		{
+			FreeSlots.Add(Slot);
+		}
+		NewestFrame = 0;
+		NumFrames = 0;
+		NumRegistered = 0;
+	}
+
+	if (FreeSlots.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("HitRewind is full, %s hits won't be rewound"), *Enemy->GetName());
+		return INDEX_NONE;
+	}
+
+	const int32 Slot = FreeSlots.Pop(false);
+	Targets[Slot] = Enemy;
+	Shapes[Slot].Radius = Enemy->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	Shapes[Slot].HalfHeight = Enemy->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+
+	// Without history yet the enemy is treated as always having been where it is now
+	const FVector Location = Enemy->GetActorLocation();
+	FVector* History = &Locations[Slot * HistoryLength];
+	for (int32 Frame = 0; Frame < HistoryLength; ++Frame)
+	{
+		History[Frame] = Location;
+	}
+
+	++NumRegistered;
+	return Slot;
+}
+
+void UHitRewindSubsystem::UnregisterTarget(int32 Slot)
+{
+	if (!Targets.IsValidIndex(Slot) || !Targets[Slot].IsValid()) return;
+
+	Targets[Slot].Reset();
+	FreeSlots.Add(Slot);
+	--NumRegistered;
+}
+
+float UHitRewindSubsystem::GetOldestTime() const
+{
+	if (NumFrames == 0) return GetRewindTime(GetWorld());
+
+	// HistoryLength frames back, about half a second at 60Hz
+	return FrameTimes[(NewestFrame - (NumFrames - 1) + HistoryLength) % HistoryLength];
+}
+
+float UHitRewindSubsystem::GetRewindTime(const UWorld* World)
+{
+	const AGameStateBase* GameState = World ? World->GetGameState() : nullptr;
+	return GameState ? GameState->GetServerWorldTimeSeconds() : (World ? World->GetTimeSeconds() : 0.f);
+}
+
+void UHitRewindSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HitRewindRecord);
+
+	NewestFrame = (NewestFrame + 1) % HistoryLength;
+	NumFrames = FMath::Min(NumFrames + 1, HistoryLength);
+	FrameTimes[NewestFrame] = GetRewindTime(GetWorld());
+
+	for (int32 Slot = 0; Slot < Targets.Num(); ++Slot)
+	{
+		if (const AEnemy* Enemy = Targets[Slot].Get())
+		{
+			Locations[Slot * HistoryLength + NewestFrame] = Enemy->GetActorLocation();
+		}
+	}
+}
+
+TStatId UHitRewindSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHitRewindSubsystem, STATGROUP_Tickables);
+}
+
+int32 UHitRewindSubsystem::FindFrame(float Time) const
+{
+	// Walk back from the newest sample, claims are usually a few frames old
+	for (int32 Age = 0; Age < NumFrames; ++Age)
+	{
+		const int32 Frame = (NewestFrame - Age + HistoryLength) % HistoryLength;
+		if (FrameTimes[Frame] <= Time)
+		{
+			return Frame;
+		}
+	}
+	return INDEX_NONE;
+}
+
+bool UHitRewindSubsystem::RewindLocation(int32 Slot, float Time, FVector& OutLocation) const
+{
+	if (!Targets.IsValidIndex(Slot) || NumFrames == 0) return false;
+
+	const int32 Frame = FindFrame(Time);
+	if (Frame == INDEX_NONE) return false;
+
+	const FVector* History = &Locations[Slot * HistoryLength];
+	if (Frame == NewestFrame)
+	{
+		OutLocation = History[Frame];
+		return true;
+	}
+
+	const int32 NextFrame = (Frame + 1) % HistoryLength;
+	const float Span = FrameTimes[NextFrame] - FrameTimes[Frame];
+	const float Alpha = Span > KINDA_SMALL_NUMBER ? (Time - FrameTimes[Frame]) / Span : 0.f;
+	OutLocation = FMath::Lerp(History[Frame], History[NextFrame], FMath::Clamp(Alpha, 0.f, 1.f));
+	return true;
+}
+
+bool UHitRewindSubsystem::ValidateHit(const AEnemy* Enemy, const FVector& HitLocation, float ClientTime, float Tolerance) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_HitRewindValidate);
+
+	if (!Enemy) return false;
+
+	// A slot handed on to another enemy would check the claim against the wrong capsule
+	const int32 Slot = Enemy->RewindSlot;
+	if (!Targets.IsValidIndex(Slot) || Targets[Slot].Get() != Enemy) return false;
+
+	FVector Center;
+	if (!RewindLocation(Slot, ClientTime, Center)) return false;
+
+	return IsWithinCapsule(HitLocation, Center, Shapes[Slot].Radius, Shapes[Slot].HalfHeight, Tolerance);
+}
+
+bool UHitRewindSubsystem::IsWithinCapsule(const FVector& Location, const FVector& Center, float Radius, float HalfHeight, float Tolerance)
+{
+	// Distance to the capsule's segment, minus its radius
+	const float SegmentHalf = FMath::Max(HalfHeight - Radius, 0.f);
+	const FVector Top = Center + FVector(0.f, 0.f, SegmentHalf);
+	const FVector Bottom = Center - FVector(0.f, 0.f, SegmentHalf);
+	const float Distance = FMath::PointDistToSegment(Location, Bottom, Top) - Radius;
+
+	return Distance <= Tolerance;
+}
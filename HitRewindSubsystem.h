@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "HitRewindSubsystem.generated.h"
+
+class AEnemy;
+
+/**
+ * Server-side history of enemy capsules, used to check melee hits claimed by clients
+ * against where the enemy was when the client swung.
+ *
+ * Memory is fixed: MaxTargets slots of HistoryLength samples, allocated on the first
+ * registration. Every frame records all slots at once, so the sample times are shared
+ * and each slot's history is one contiguous run of locations.
+ */
+UCLASS()
+class FIRSTPROJECT_20_API UHitRewindSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UHitRewindSubsystem();
+
+	static constexpr int32 MaxTargets = 1024;
+	static constexpr int32 HistoryLength = 32;
+
+	virtual void Deinitialize() override;
+
+	/** Returns the slot to pass back in, INDEX_NONE if full or not the server */
+	int32 RegisterTarget(AEnemy* Enemy);
+	void UnregisterTarget(int32 Slot);
+
+	/** Capsule center of the slot at Time, interpolated between samples. False if Time is outside the history */
+	bool RewindLocation(int32 Slot, float Time, FVector& OutLocation) const;
+
+	/**
+	 * Was HitLocation within Tolerance of the enemy's capsule at ClientTime. False when the
+	 * enemy isn't tracked, its slot belongs to another enemy or ClientTime is outside the history
+	 */
+	bool ValidateHit(const AEnemy* Enemy, const FVector& HitLocation, float ClientTime, float Tolerance) const;
+
+	/** Time of the oldest sample still in the history, claims further back can't be checked */
+	float GetOldestTime() const;
+
+	/** Server time both sides agree on, what clients send with their hit claims */
+	static float GetRewindTime(const UWorld* World);
+
+	/** Is Location within Tolerance of an upright capsule centered on Center */
+	static bool IsWithinCapsule(const FVector& Location, const FVector& Center, float Radius, float HalfHeight, float Tolerance);
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return NumRegistered > 0; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+protected:
+
+	friend class FHitRewindValidateHitTest;
+
+	/** RegisterTarget without the server check, INDEX_NONE if full */
+	int32 AddTarget(AEnemy* Enemy);
+
+	struct FTargetShape
+	{
+		float Radius;
+		float HalfHeight;
+	};
+
+	/** Samples of slot S live at [S * HistoryLength, (S + 1) * HistoryLength) */
+	TArray<FVector> Locations;
+	TArray<FTargetShape> Shapes;
+	TArray<TWeakObjectPtr<AEnemy>> Targets;
+	TArray<int32> FreeSlots;
+
+	float FrameTimes[HistoryLength];
+
+	/** Ring index of the newest sample and how many are valid */
+	int32 NewestFrame;
+	int32 NumFrames;
+	int32 NumRegistered;
+
+	/** Index into FrameTimes of the newest sample not after Time */
+	int32 FindFrame(float Time) const;
+};
@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HitRewindSubsystem.h"
+#include "Enemy.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHitRewindValidateHitTest, "FirstProject.HitRewind.ValidateHit", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FHitRewindValidateHitTest::RunTest(const FString& Parameters)
+{
+	// Never begins play, the enemies are only there for their capsules
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	UHitRewindSubsystem* HitRewind = World->GetSubsystem<UHitRewindSubsystem>();
+	if (!TestNotNull(TEXT("HitRewind subsystem"), HitRewind))
+	{
+		World->DestroyWorld(false);
+		return false;
+	}
+
+	const FVector Start(0.f, 0.f, 100.f);
+	const FVector End(1000.f, 0.f, 100.f);
+	const float Tolerance = 10.f;
+
+	AEnemy* Enemy = World->SpawnActor<AEnemy>(Start, FRotator::ZeroRotator);
+	AEnemy* Other = World->SpawnActor<AEnemy>(End, FRotator::ZeroRotator);
+	AEnemy* Untracked = World->SpawnActor<AEnemy>(Start, FRotator::ZeroRotator);
+
+	Enemy->RewindSlot = HitRewind->AddTarget(Enemy);
+	TestNotEqual(TEXT("Enemy gets a slot"), Enemy->RewindSlot, (int32)INDEX_NONE);
+
+	// Two samples: at Start at 1s, at End at 2s
+	World->TimeSeconds = 1.f;
+	HitRewind->Tick(0.f);
+	Enemy->SetActorLocation(End);
+	World->TimeSeconds = 2.f;
+	HitRewind->Tick(0.f);
+
+	TestTrue(TEXT("Hit where the enemy was"), HitRewind->ValidateHit(Enemy, Start, 1.f, Tolerance));
+	TestFalse(TEXT("Hit where the enemy was, claimed after it moved"), HitRewind->ValidateHit(Enemy, Start, 2.f, Tolerance));
+	TestTrue(TEXT("Hit where the enemy is now"), HitRewind->ValidateHit(Enemy, End, 2.f, Tolerance));
+	TestFalse(TEXT("Claim older than the history"), HitRewind->ValidateHit(Enemy, Start, 0.5f, Tolerance));
+	TestFalse(TEXT("Enemy that isn't tracked"), HitRewind->ValidateHit(Untracked, Start, 1.f, Tolerance));
+
+	// Another enemy pointing at the slot must not pass as its owner
+	Other->RewindSlot = Enemy->RewindSlot;
+	TestFalse(TEXT("Slot owned by another enemy"), HitRewind->ValidateHit(Other, End, 2.f, Tolerance));
+
+	// Once the slot is handed on, the old owner's claims are rejected
+	const int32 Slot = Enemy->RewindSlot;
+	HitRewind->UnregisterTarget(Slot);
+	Other->RewindSlot = HitRewind->AddTarget(Other);
+	TestEqual(TEXT("Freed slot is reused"), Other->RewindSlot, Slot);
+	TestFalse(TEXT("Stale slot"), HitRewind->ValidateHit(Enemy, End, 2.f, Tolerance));
+
+	// Capsule shape: radius 30, half height 90
+	TestTrue(TEXT("Inside the capsule"), UHitRewindSubsystem::IsWithinCapsule(FVector(20.f, 0.f, 50.f), FVector::ZeroVector, 30.f, 90.f, 0.f));
+	TestTrue(TEXT("Just outside, within tolerance"), UHitRewindSubsystem::IsWithinCapsule(FVector(35.f, 0.f, 0.f), FVector::ZeroVector, 30.f, 90.f, Tolerance));
+	TestFalse(TEXT("Beside the capsule"), UHitRewindSubsystem::IsWithinCapsule(FVector(50.f, 0.f, 0.f), FVector::ZeroVector, 30.f, 90.f, Tolerance));
+	TestFalse(TEXT("Above the capsule"), UHitRewindSubsystem::IsWithinCapsule(FVector(0.f, 0.f, 110.f), FVector::ZeroVector, 30.f, 90.f, Tolerance));
+
+	World->DestroyWorld(false);
+	return true;
+}
+
+#endif
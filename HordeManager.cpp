@@ -0,0 +1,411 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HordeManager.h"
+#include "FirstProject_20.h"
+#include "FirstProjectCosmetics.h"
+#include "Enemy.h"
+#include "Main.h"
+#include "AIController.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "NavigationSystem.h"
+#include "EngineUtils.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+DECLARE_CYCLE_STAT(TEXT("Horde Simulate"), STAT_HordeSimulate, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Horde Promotions"), STAT_HordePromotions, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Horde Instances"), STAT_HordeInstances, STATGROUP_FirstProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Horde Agents"), STAT_HordeAgents, STATGROUP_FirstProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Horde Promoted"), STAT_HordePromoted, STATGROUP_FirstProject);
+
+// Sets default values
+AHordeManager::AHordeManager()
+{
+ 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+	PrimaryActorTick.bCanEverTick = true;
+
+	AgentInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("AgentInstances"));
+	RootComponent = AgentInstances;
+	AgentInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	AgentInstances->SetCastShadow(false);
+
+	NumAgents = 2000;
+	SpawnRadius = 10000.f;
+	HordeSeed = 1234;
+	AgentSpeed = 250.f;
+	StopRadius = 800.f;
+	PromoteRadius = 2500.f;
+	DemoteRadius = 3500.f;
+	MaxPromoted = 200;
+	MaxPromotionsPerFrame = 8;
+	PoolPrewarm = 32;
+
+	NumPromoted = 0;
+	ReplicatedStates.Owner = this;
+
+	// Only the agent states go over the network, every client runs its own copy of the horde
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	SetReplicatingMovement(false);
+}
+
+void AHordeManager::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AHordeManager, ReplicatedStates, Params);
+}
+
+void FHordeAgentStateItem::PostReplicatedAdd(const FHordeAgentStateArray& InArraySerializer)
+{
+	InArraySerializer.Owner->OnAgentStateReplicated(Agent, State);
+}
+
+void FHordeAgentStateItem::PostReplicatedChange(const FHordeAgentStateArray& InArraySerializer)
+{
+	InArraySerializer.Owner->OnAgentStateReplicated(Agent, State);
+}
+
+void FHordeAgentStateItem::PreReplicatedRemove(const FHordeAgentStateArray& InArraySerializer)
+{
+	InArraySerializer.Owner->OnAgentStateReplicated(Agent, EHordeAgentState::EHAS_Simulated);
+}
+
+void AHordeManager::OnAgentStateReplicated(int32 Agent, EHordeAgentState State)
+{
+	// Entries can arrive before BeginPlay sized the array, BeginPlay picks those up
+	if (AgentStates.IsValidIndex(Agent))
+	{
+		AgentStates[Agent] = (uint8)State;
+	}
+}
+
+// Called when the game starts or when spawned
+void AHordeManager::BeginPlay()
+{
+	LLM_SCOPE_BYTAG(FirstProject_Enemies);
+
+	Super::BeginPlay();
+
+	// Own stream rather than the shared ones so clients lay out the exact same horde
+	FRandomStream Stream(HordeSeed);
+	const FVector Origin = GetActorLocation();
+
+	PosX.SetNumUninitialized(NumAgents);
+	PosY.SetNumUninitialized(NumAgents);
+	PosZ.SetNumUninitialized(NumAgents);
+	VelX.SetNumZeroed(NumAgents);
+	VelY.SetNumZeroed(NumAgents);
+	Health.SetNumUninitialized(NumAgents);
+	NearestDistSq.Init(MAX_FLT, NumAgents);
+	PromotedEnemies.Init(nullptr, NumAgents);
+	AgentStates.Init((uint8)EHordeAgentState::EHAS_Simulated, NumAgents);
+	for (const FHordeAgentStateItem& Item : ReplicatedStates.Items)
+	{
+		OnAgentStateReplicated(Item.Agent, Item.State);
+	}
+
+	const AEnemy* EnemyDefaults = EnemyClass ? EnemyClass->GetDefaultObject<AEnemy>() : GetDefault<AEnemy>();
+	for (int32 i = 0; i < NumAgents; ++i)
+	{
+		// Uniform over the disc
+		const float Angle = Stream.FRandRange(0.f, 2.f * PI);
+		const float Distance = SpawnRadius * FMath::Sqrt(Stream.FRand());
+		FVector Location = Origin + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * Distance;
+
+		// Drop onto the ground, the navmesh isn't there on clients
+		FHitResult Hit;
+		if (GetWorld()->LineTraceSingleByChannel(Hit, Location + FVector(0.f, 0.f, 1000.f), Location - FVector(0.f, 0.f, 2000.f), ECC_WorldStatic))
+		{
+			Location = Hit.ImpactPoint;
+		}
+
+		PosX[i] = Location.X;
+		PosY[i] = Location.Y;
+		PosZ[i] = Location.Z;
+		Health[i] = EnemyDefaults->Health;
+	}
+
+	if (FFirstProjectCosmetics::ShouldPlayCosmetics(this))
+	{
+		InstanceTransforms.SetNum(NumAgents);
+		for (int32 i = 0; i < NumAgents; ++i)
+		{
+			AgentInstances->AddInstanceWorldSpace(FTransform(FVector(PosX[i], PosY[i], PosZ[i])));
+		}
+	}
+
+	if (HasAuthority() && EnemyClass)
+	{
+		for (int32 i = 0; i < PoolPrewarm; ++i)
+		{
+			if (AEnemy* Enemy = SpawnPooledEnemy())
+			{
+				Enemy->SetPooled(true);
+				Pool.Add(Enemy);
+			}
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_HordeAgents, NumAgents);
+}
+
+void AHordeManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	DEC_DWORD_STAT_BY(STAT_HordeAgents, NumAgents);
+	DEC_DWORD_STAT_BY(STAT_HordePromoted, NumPromoted);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Called every frame
+void AHordeManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	Simulate(DeltaTime);
+
+	if (HasAuthority())
+	{
+		UpdatePromotions();
+	}
+
+#if FIRSTPROJECT_WITH_COSMETICS
+	if (InstanceTransforms.Num() > 0)
+	{
+		UpdateInstances();
+	}
+#endif
+}
+
+void AHordeManager::Simulate(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HordeSimulate);
+
+	TArray<FVector2D, TInlineAllocator<8>> Players;
+	for (TActorIterator<AMain> It(GetWorld()); It; ++It)
+	{
+		Players.Add(FVector2D(It->GetActorLocation()));
+	}
+	if (Players.Num() == 0)
+		return;
+
+	// Every agent goes through the same branch-free steps, promoted and dead ones included,
+	// so the compiler can keep this loop vectorized. Their results just aren't used
+	float* RESTRICT X = PosX.GetData();
+	float* RESTRICT Y = PosY.GetData();
+	float* RESTRICT VX = VelX.GetData();
+	float* RESTRICT VY = VelY.GetData();
+	float* RESTRICT DistSq = NearestDistSq.GetData();
+
+	const int32 Num = PosX.Num();
+	const float StopSq = StopRadius * StopRadius;
+	const float Blend = FMath::Min(DeltaTime * 4.f, 1.f);
+
+	for (int32 i = 0; i < Num; ++i)
+	{
+		float BestDX = 0.f;
+		float BestDY = 0.f;
+		float BestSq = MAX_FLT;
+		for (const FVector2D& Player : Players)
+		{
+			const float DX = Player.X - X[i];
+			const float DY = Player.Y - Y[i];
+			const float Sq = DX * DX + DY * DY;
+			const bool bCloser = Sq < BestSq;
+			BestDX = bCloser ? DX : BestDX;
+			BestDY = bCloser ? DY : BestDY;
+			BestSq = bCloser ? Sq : BestSq;
+		}
+
+		const float Scale = BestSq > StopSq ? AgentSpeed * FMath::InvSqrt(BestSq) : 0.f;
+		VX[i] += (BestDX * Scale - VX[i]) * Blend;
+		VY[i] += (BestDY * Scale - VY[i]) * Blend;
+		X[i] += VX[i] * DeltaTime;
+		Y[i] += VY[i] * DeltaTime;
+		DistSq[i] = BestSq;
+	}
+}
+
+void AHordeManager::UpdatePromotions()
+{
+	SCOPE_CYCLE_COUNTER(STAT_HordePromotions);
+
+	const float PromoteSq = PromoteRadius * PromoteRadius;
+	const float DemoteSq = DemoteRadius * DemoteRadius;
+	int32 Promotions = 0;
+
+	for (int32 i = 0; i < AgentStates.Num(); ++i)
+	{
+		const EHordeAgentState State = (EHordeAgentState)AgentStates[i];
+		if (State == EHordeAgentState::EHAS_Simulated)
+		{
+			if (NearestDistSq[i] < PromoteSq && NumPromoted < MaxPromoted && Promotions < MaxPromotionsPerFrame)
+			{
+				Promote(i);
+				++Promotions;
+			}
+		}
+		else if (State == EHordeAgentState::EHAS_Promoted)
+		{
+			AEnemy* Enemy = PromotedEnemies[i];
+			if (!IsValid(Enemy) || !Enemy->Alive())
+			{
+				// Killed as a real enemy, it plays its death and destroys itself
+				PromotedEnemies[i] = nullptr;
+				--NumPromoted;
+				DEC_DWORD_STAT(STAT_HordePromoted);
+				SetAgentState(i, EHordeAgentState::EHAS_Dead);
+				continue;
+			}
+
+			// The actor is the truth while promoted
+			const FVector Location = Enemy->GetActorLocation();
+			PosX[i] = Location.X;
+			PosY[i] = Location.Y;
+			PosZ[i] = Location.Z - Enemy->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+			VelX[i] = Enemy->GetVelocity().X;
+			VelY[i] = Enemy->GetVelocity().Y;
+
+			const bool bBusy = Enemy->AIState == EEnemyAIState::EAS_Attack || Enemy->AIState == EEnemyAIState::EAS_Recover;
+			if (NearestDistSq[i] > DemoteSq && !bBusy)
+			{
+				Demote(i);
+			}
+		}
+	}
+}
+
+void AHordeManager::UpdateInstances()
+{
+	SCOPE_CYCLE_COUNTER(STAT_HordeInstances);
+
+	const int32 Num = InstanceTransforms.Num();
+	for (int32 i = 0; i < Num; ++i)
+	{
+		// Agents standing in as real enemies, or dead, are scaled away
+		const bool bVisible = AgentStates.IsValidIndex(i) && AgentStates[i] == (uint8)EHordeAgentState::EHAS_Simulated;
+		const float Yaw = FMath::RadiansToDegrees(FMath::Atan2(VelY[i], VelX[i]));
+		InstanceTransforms[i] = FTransform(FRotator(0.f, Yaw, 0.f), FVector(PosX[i], PosY[i], PosZ[i]), bVisible ? FVector::OneVector : FVector::ZeroVector);
+	}
+
+	AgentInstances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, false);
+}
+
+void AHordeManager::Promote(int32 Agent)
+{
+	AEnemy* Enemy = Pool.Num() > 0 ? Pool.Pop(false) : SpawnPooledEnemy();
+	if (Enemy == nullptr)
+		return;
+
+	// Agents only move in X and Y, put the enemy back on the navmesh before it has to walk on it
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	FNavLocation NavLocation;
+	if (NavSys && NavSys->ProjectPointToNavigation(FVector(PosX[Agent], PosY[Agent], PosZ[Agent]), NavLocation, FVector(100.f, 100.f, 1000.f)))
+	{
+		PosX[Agent] = NavLocation.Location.X;
+		PosY[Agent] = NavLocation.Location.Y;
+		PosZ[Agent] = NavLocation.Location.Z;
+	}
+
+	const float HalfHeight = Enemy->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	const FRotator Facing(0.f, FMath::RadiansToDegrees(FMath::Atan2(VelY[Agent], VelX[Agent])), 0.f);
+	Enemy->SetActorLocationAndRotation(FVector(PosX[Agent], PosY[Agent], PosZ[Agent] + HalfHeight), Facing, false, nullptr, ETeleportType::TeleportPhysics);
+	Enemy->SetHealth(Health[Agent]);
+	Enemy->SetPooled(false);
+
+	// The agent was already on its way to a player, carry that on instead of waiting for the agro sphere
+	if (AMain* Target = FindNearestPlayer(Enemy->GetActorLocation()))
+	{
+		Enemy->AgroTarget = Target;
+		Enemy->SetAIState(EEnemyAIState::EAS_Chase, GetWorld()->GetTimeSeconds());
+	}
+
+	PromotedEnemies[Agent] = Enemy;
+	++NumPromoted;
+	INC_DWORD_STAT(STAT_HordePromoted);
+	SetAgentState(Agent, EHordeAgentState::EHAS_Promoted);
+}
+
+void AHordeManager::Demote(int32 Agent)
+{
+	AEnemy* Enemy = PromotedEnemies[Agent];
+	Health[Agent] = Enemy->Health;
+	Enemy->SetPooled(true);
+	Pool.Add(Enemy);
+
+	PromotedEnemies[Agent] = nullptr;
+	--NumPromoted;
+	DEC_DWORD_STAT(STAT_HordePromoted);
+	SetAgentState(Agent, EHordeAgentState::EHAS_Simulated);
+}
+
+void AHordeManager::SetAgentState(int32 Agent, EHordeAgentState State)
+{
+	AgentStates[Agent] = (uint8)State;
+
+	TArray<FHordeAgentStateItem>& Items = ReplicatedStates.Items;
+	const int32 ItemIndex = Items.IndexOfByPredicate([Agent](const FHordeAgentStateItem& Item) { return Item.Agent == Agent; });
+	if (State == EHordeAgentState::EHAS_Simulated)
+	{
+		if (ItemIndex != INDEX_NONE)
+		{
+			Items.RemoveAtSwap(ItemIndex);
+			ReplicatedStates.MarkArrayDirty();
+		}
+	}
+	else if (ItemIndex != INDEX_NONE)
+	{
+		Items[ItemIndex].State = State;
+		ReplicatedStates.MarkItemDirty(Items[ItemIndex]);
+	}
+	else
+	{
+		FHordeAgentStateItem& Item = Items.AddDefaulted_GetRef();
+		Item.Agent = Agent;
+		Item.State = State;
+		ReplicatedStates.MarkItemDirty(Item);
+	}
+	MARK_PROPERTY_DIRTY_FROM_NAME(AHordeManager, ReplicatedStates, this);
+}
+
+AMain* AHordeManager::FindNearestPlayer(const FVector& Location) const
+{
+	AMain* Nearest = nullptr;
+	float NearestSq = MAX_FLT;
+	for (TActorIterator<AMain> It(GetWorld()); It; ++It)
+	{
+		const float Sq = FVector::DistSquared2D(Location, It->GetActorLocation());
+		if (Sq < NearestSq && It->MovementStatus != EMovementStatus::EMS_Dead)
+		{
+			Nearest = *It;
+			NearestSq = Sq;
+		}
+	}
+	return Nearest;
+}
+
+AEnemy* AHordeManager::SpawnPooledEnemy()
+{
+	LLM_SCOPE_BYTAG(FirstProject_Enemies);
+
+	if (EnemyClass == nullptr)
+		return nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AEnemy* Enemy = GetWorld()->SpawnActor<AEnemy>(EnemyClass, GetActorLocation(), FRotator::ZeroRotator, SpawnParams);
+	if (Enemy)
+	{
+		INC_DWORD_STAT(STAT_Spawns);
+
+		// Same as ASpawnVolume, the controller has to exist before the first Think
+		Enemy->SpawnDefaultController();
+		Enemy->AIController = Cast<AAIController>(Enemy->GetController());
+	}
+	return Enemy;
+}
@@ -0,0 +1,189 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Engine/NetSerialization.h"
+#include "HordeManager.generated.h"
+
+class AEnemy;
+class AHordeManager;
+
+UENUM()
+enum class EHordeAgentState : uint8
+{
+	EHAS_Simulated,
+	EHAS_Promoted,
+	EHAS_Dead
+};
+
+/** An agent that isn't plain simulated, simulated agents have no entry */
+USTRUCT()
+struct FHordeAgentStateItem : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Agent = INDEX_NONE;
+
+	UPROPERTY()
+	EHordeAgentState State = EHordeAgentState::EHAS_Simulated;
+
+	void PostReplicatedAdd(const struct FHordeAgentStateArray& InArraySerializer);
+	void PostReplicatedChange(const struct FHordeAgentStateArray& InArraySerializer);
+	void PreReplicatedRemove(const struct FHordeAgentStateArray& InArraySerializer);
+};
+
+/**
+ * Only the agents whose state changed go over the wire, and there's no cap on how many
+ * entries it holds, unlike a replicated TArray which is bound by net.MaxRepArraySize.
+ */
+USTRUCT()
+struct FHordeAgentStateArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FHordeAgentStateItem> Items;
+
+	/** Told about every replicated change so it can update its local states */
+	UPROPERTY(NotReplicated)
+	AHordeManager* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FHordeAgentStateItem, FHordeAgentStateArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FHordeAgentStateArray> : public TStructOpsTypeTraitsBase2<FHordeAgentStateArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/**
+ * Thousands of background enemies as plain arrays, drawn with one instanced mesh.
+ *
+ * Agents are spawned from HordeSeed so every machine starts with the same horde. Each one
+ * heads for the nearest AMain in a flat loop over the position and velocity arrays. On the
+ * server, agents that get within PromoteRadius of a player are swapped for a real AEnemy
+ * from a pool, and go back to being an agent once they're beyond DemoteRadius. Only the
+ * promoted and dead agents replicate, as a fast array, so clients know which agents to hide.
+ */
+UCLASS()
+class FIRSTPROJECT_20_API AHordeManager : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	// Sets default values for this actor's properties
+	AHordeManager();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Horde")
+	class UInstancedStaticMeshComponent* AgentInstances;
+
+	/** What agents turn into up close */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	TSubclassOf<AEnemy> EnemyClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	int32 NumAgents;
+
+	/** Agents start within this distance of the manager */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	float SpawnRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	int32 HordeSeed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	float AgentSpeed;
+
+	/** Agents stop this far from the player, only promoted enemies fight */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	float StopRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	float PromoteRadius;
+
+	/** Larger than PromoteRadius so agents at the edge don't flip back and forth */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	float DemoteRadius;
+
+	/** Most real AEnemy actors the horde has out at once */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	int32 MaxPromoted;
+
+	/** Spreads the spawn and activation cost when a crowd reaches the player */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	int32 MaxPromotionsPerFrame;
+
+	/** Pooled enemies spawned up front */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Horde")
+	int32 PoolPrewarm;
+
+	UFUNCTION(BlueprintCallable, Category = "Horde")
+	int32 GetNumPromoted() const { return NumPromoted; }
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:	
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	/** Client: an entry of ReplicatedStates arrived, changed or went away */
+	void OnAgentStateReplicated(int32 Agent, EHordeAgentState State);
+
+protected:
+
+	/** EHordeAgentState per agent, the server's copy is the truth and clients mirror ReplicatedStates */
+	TArray<uint8> AgentStates;
+
+	UPROPERTY(Replicated)
+	FHordeAgentStateArray ReplicatedStates;
+
+	TArray<float> PosX;
+	TArray<float> PosY;
+	TArray<float> PosZ;
+	TArray<float> VelX;
+	TArray<float> VelY;
+	TArray<float> Health;
+
+	/** Squared distance to the nearest player from the last step */
+	TArray<float> NearestDistSq;
+
+	/** The actor standing in for each promoted agent */
+	UPROPERTY(Transient)
+	TArray<AEnemy*> PromotedEnemies;
+
+	UPROPERTY(Transient)
+	TArray<AEnemy*> Pool;
+
+	int32 NumPromoted;
+
+	TArray<FTransform> InstanceTransforms;
+
+	void Simulate(float DeltaTime);
+	void UpdatePromotions();
+	void UpdateInstances();
+
+	void Promote(int32 Agent);
+	void Demote(int32 Agent);
+	void SetAgentState(int32 Agent, EHordeAgentState State);
+
+	AEnemy* SpawnPooledEnemy();
+
+	/** Closest player to the location, what a freshly promoted enemy goes after */
+	class AMain* FindNearestPlayer(const FVector& Location) const;
+};
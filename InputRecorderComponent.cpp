@@ -0,0 +1,314 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "InputRecorderComponent.h"
+#include "Main.h"
+#include "RandomStreamSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Components/InputComponent.h"
+#include "HAL/FileManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Paths.h"
+#include "Serialization/Archive.h"
+
+namespace
+{
+	const uint32 RecordingMagic = 0x52495046; // "FPIR"
+	const uint16 RecordingVersion = 1;
+
+	const FName AxisNames[FRecordedInputFrame::NumAxes] =
+	{
+		TEXT("MoveForward"), TEXT("MoveRight"), TEXT("Turn"), TEXT("LookUp"), TEXT("TurnRate"), TEXT("LookUpRate")
+	};
+}
+
+// Sets default values for this component's properties
+UInputRecorderComponent::UInputRecorderComponent()
+{
+	// Only ticks while recording or replaying
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+
+	FixedFrameRate = 60.f;
+	RecordingSeed = 12345;
+	Mode = EInputRecorderMode::EIRM_Idle;
+
+	Seed = 0;
+	FrameIndex = 0;
+	PreviousButtons = 0;
+	bExitWhenReplayDone = false;
+	bPreviousUseFixedTimeStep = false;
+	PreviousFixedDeltaTime = 0.0;
+}
+
+// Called when the game starts
+void UInputRecorderComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	FString ReplayName;
+	if (FParse::Value(FCommandLine::Get(), TEXT("ReplayInput="), ReplayName))
+	{
+		bExitWhenReplayDone = FParse::Param(FCommandLine::Get(), TEXT("ReplayExit"));
+		StartReplay(ReplayName);
+	}
+}
+
+void UInputRecorderComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Stop();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+AMain* UInputRecorderComponent::GetMain() const
+{
+	return Cast<AMain>(GetOwner());
+}
+
+FString UInputRecorderComponent::GetRecordingPath(const FString& Name)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("InputRecordings"), Name + TEXT(".fpinput"));
+}
+
+void UInputRecorderComponent::StartRecording(const FString& Name)
+{
+	AMain* Main = GetMain();
+	if (Mode != EInputRecorderMode::EIRM_Idle || Main == nullptr || Main->GetController() == nullptr)
+		return;
+
+	RecordingName = Name;
+	Frames.Reset();
+	BeginDeterministicRun(RecordingSeed);
+
+	// Sample after the controller has run the input bindings this frame
+	AddTickPrerequisiteActor(Main->GetController());
+
+	Mode = EInputRecorderMode::EIRM_Recording;
+	SetComponentTickEnabled(true);
+
+	UE_LOG(LogTemp, Display, TEXT("InputRecorder: recording %s"), *GetRecordingPath(Name));
+}
+
+bool UInputRecorderComponent::StartReplay(const FString& Name)
+{
+	AMain* Main = GetMain();
+	if (Mode != EInputRecorderMode::EIRM_Idle || Main == nullptr)
+		return false;
+
+	APlayerController* PlayerController = Cast<APlayerController>(Main->GetController());
+	if (PlayerController == nullptr || !LoadRecording(GetRecordingPath(Name)))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("InputRecorder: can't replay %s"), *Name);
+		return false;
+	}
+
+	RecordingName = Name;
+	FrameIndex = 0;
+	PreviousButtons = 0;
+	BeginDeterministicRun(Seed);
+
+	// Live input is ignored, recorded input goes in before the controller updates rotation
+	Main->DisableInput(PlayerController);
+	PlayerController->AddTickPrerequisiteComponent(this);
+
+	Mode = EInputRecorderMode::EIRM_Replaying;
+	SetComponentTickEnabled(true);
+
+	UE_LOG(LogTemp, Display, TEXT("InputRecorder: replaying %s, %d frames"), *Name, Frames.Num());
+	return true;
+}
+
+void UInputRecorderComponent::Stop()
+{
+	AMain* Main = GetMain();
+	AController* Controller = Main ? Main->GetController() : nullptr;
+
+	if (Mode == EInputRecorderMode::EIRM_Recording)
+	{
+		if (Controller)
+		{
+			RemoveTickPrerequisiteActor(Controller);
+		}
+		SaveRecording();
+	}
+	else if (Mode == EInputRecorderMode::EIRM_Replaying)
+	{
+		APlayerController* PlayerController = Cast<APlayerController>(Controller);
+		if (PlayerController)
+		{
+			PlayerController->RemoveTickPrerequisiteComponent(this);
+			Main->EnableInput(PlayerController);
+		}
+		UE_LOG(LogTemp, Display, TEXT("InputRecorder: replay of %s done after %d frames"), *RecordingName, FrameIndex);
+	}
+	else
+	{
+		return;
+	}
+
+	Mode = EInputRecorderMode::EIRM_Idle;
+	SetComponentTickEnabled(false);
+	EndDeterministicRun();
+}
+
+// Called every frame
+void UInputRecorderComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (Mode == EInputRecorderMode::EIRM_Recording)
+	{
+		RecordFrame();
+	}
+	else if (Mode == EInputRecorderMode::EIRM_Replaying)
+	{
+		if (FrameIndex < Frames.Num())
+		{
+			ReplayFrame();
+		}
+		else
+		{
+			Stop();
+			if (bExitWhenReplayDone)
+			{
+				FPlatformMisc::RequestExit(false);
+			}
+		}
+	}
+}
+
+void UInputRecorderComponent::RecordFrame()
+{
+	AMain* Main = GetMain();
+	if (Main == nullptr || Main->InputComponent == nullptr)
+		return;
+
+	FRecordedInputFrame& Frame = Frames.AddDefaulted_GetRef();
+	for (int32 i = 0; i < FRecordedInputFrame::NumAxes; i++)
+	{
+		Frame.Axes[i] = Main->InputComponent->GetAxisValue(AxisNames[i]);
+	}
+
+	Frame.Buttons = 0;
+	Frame.Buttons |= Main->bPressedJump ? FRecordedInputFrame::Jump : 0;
+	Frame.Buttons |= Main->bShiftKeyDown ? FRecordedInputFrame::Sprint : 0;
+	Frame.Buttons |= Main->bLMBDown ? FRecordedInputFrame::LMB : 0;
+	Frame.Buttons |= Main->bESCDown ? FRecordedInputFrame::ESC : 0;
+}
+
+void UInputRecorderComponent::ReplayFrame()
+{
+	AMain* Main = GetMain();
+	if (Main == nullptr)
+		return;
+
+	const FRecordedInputFrame& Frame = Frames[FrameIndex++];
+
+	// Same handlers SetupPlayerInputComponent binds
+	Main->MoveForward(Frame.Axes[FRecordedInputFrame::MoveForward]);
+	Main->MoveRight(Frame.Axes[FRecordedInputFrame::MoveRight]);
+	Main->AddControllerYawInput(Frame.Axes[FRecordedInputFrame::Turn]);
+	Main->AddControllerPitchInput(Frame.Axes[FRecordedInputFrame::LookUp]);
+	Main->TurnAtRate(Frame.Axes[FRecordedInputFrame::TurnRate]);
+	Main->LookUpAtRate(Frame.Axes[FRecordedInputFrame::LookUpRate]);
+
+	// Buttons are stored as held state, fire the handlers on the edges
+	uint8 Pressed = Frame.Buttons & ~PreviousButtons;
+	uint8 Released = PreviousButtons & ~Frame.Buttons;
+	PreviousButtons = Frame.Buttons;
+
+	if (Pressed & FRecordedInputFrame::Jump) Main->Jump();
+	if (Released & FRecordedInputFrame::Jump) Main->StopJumping();
+	if (Pressed & FRecordedInputFrame::Sprint) Main->ShiftKeyDown();
+	if (Released & FRecordedInputFrame::Sprint) Main->ShiftKeyUp();
+	if (Pressed & FRecordedInputFrame::LMB) Main->LMBDown();
+	if (Released & FRecordedInputFrame::LMB) Main->LMBUp();
+	if (Pressed & FRecordedInputFrame::ESC) Main->ESCDown();
+	if (Released & FRecordedInputFrame::ESC) Main->ESCUp();
+}
+
+bool UInputRecorderComponent::SaveRecording() const
+{
+	FString Path = GetRecordingPath(RecordingName);
+	TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileWriter(*Path));
+	if (!Ar)
+	{
+		UE_LOG(LogTemp, Error, TEXT("InputRecorder: can't write %s"), *Path);
+		return false;
+	}
+
+	uint32 Magic = RecordingMagic;
+	uint16 Version = RecordingVersion;
+	int32 SavedSeed = Seed;
+	float FrameRate = FixedFrameRate;
+	int32 NumFrames = Frames.Num();
+
+	*Ar << Magic << Version << SavedSeed << FrameRate << NumFrames;
+	for (FRecordedInputFrame Frame : Frames)
+	{
+		*Ar << Frame;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("InputRecorder: wrote %d frames to %s"), NumFrames, *Path);
+	return Ar->Close();
+}
+
+bool UInputRecorderComponent::LoadRecording(const FString& Path)
+{
+	TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileReader(*Path));
+	if (!Ar)
+		return false;
+
+	uint32 Magic = 0;
+	uint16 Version = 0;
+	int32 NumFrames = 0;
+
+	*Ar << Magic << Version;
+	if (Magic != RecordingMagic || Version != RecordingVersion)
+		return false;
+
+	*Ar << Seed << FixedFrameRate << NumFrames;
+	if (NumFrames < 0 || Ar->IsError())
+		return false;
+
+	Frames.SetNum(NumFrames);
+	for (FRecordedInputFrame& Frame : Frames)
+	{
+		*Ar << Frame;
+	}
+
+	return !Ar->IsError();
+}
+
+void UInputRecorderComponent::BeginDeterministicRun(int32 RunSeed)
+{
+	Seed = RunSeed;
+
+	bPreviousUseFixedTimeStep = FApp::UseFixedTimeStep();
+	PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(1.0 / FMath::Max(FixedFrameRate, 1.f));
+
+	FMath::RandInit(Seed);
+	FMath::SRandInit(Seed);
+
+	// Gameplay rolls come from the per-subsystem streams
+	UGameInstance* GameInstance = GetOwner() ? GetOwner()->GetGameInstance() : nullptr;
+	URandomStreamSubsystem* Random = GameInstance ? GameInstance->GetSubsystem<URandomStreamSubsystem>() : nullptr;
+	if (Random)
+	{
+		Random->SetSessionSeed(Seed);
+	}
+}
+
+void UInputRecorderComponent::EndDeterministicRun()
+{
+	FApp::SetUseFixedTimeStep(bPreviousUseFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+}
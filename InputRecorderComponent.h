@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Math/Float16.h"
+#include "InputRecorderComponent.generated.h"
+
+UENUM(BlueprintType)
+enum class EInputRecorderMode : uint8
+{
+	EIRM_Idle UMETA(DisplayName = "Idle"),
+	EIRM_Recording UMETA(DisplayName = "Recording"),
+	EIRM_Replaying UMETA(DisplayName = "Replaying"),
+
+	EIRM_MAX UMETA(DisplayName = "DefaultMAX")
+};
+
+/** One frame of AMain input, 13 bytes on disk */
+struct FRecordedInputFrame
+{
+	enum EAxis : uint8 { MoveForward, MoveRight, Turn, LookUp, TurnRate, LookUpRate, NumAxes };
+	enum EButton : uint8 { Jump = 1 << 0, Sprint = 1 << 1, LMB = 1 << 2, ESC = 1 << 3 };
+
+	FFloat16 Axes[NumAxes];
+	uint8 Buttons;
+
+	friend FArchive& operator<<(FArchive& Ar, FRecordedInputFrame& Frame)
+	{
+		for (FFloat16& Axis : Frame.Axes)
+		{
+			Ar << Axis;
+		}
+		Ar << Frame.Buttons;
+		return Ar;
+	}
+};
+
+/**
+ * Records the per-frame axis and button stream of the owning AMain to a binary file
+ * and feeds it back later. Both run at a fixed timestep with a seeded random stream,
+ * so a replay plays out the same session on every run and build.
+ * Start from the console (RecordInput / ReplayInput / StopInput on AMainPlayerController)
+ * or with -ReplayInput=<name> on the command line, -ReplayExit quits when it's done.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class FIRSTPROJECT_20_API UInputRecorderComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:	
+	// Sets default values for this component's properties
+	UInputRecorderComponent();
+
+	/** Timestep used while recording and replaying */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input Recording")
+	float FixedFrameRate;
+
+	/** Random seed written into new recordings */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Input Recording")
+	int32 RecordingSeed;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Input Recording")
+	EInputRecorderMode Mode;
+
+	UFUNCTION(BlueprintCallable, Category = "Input Recording")
+	void StartRecording(const FString& Name);
+
+	UFUNCTION(BlueprintCallable, Category = "Input Recording")
+	bool StartReplay(const FString& Name);
+
+	/** Ends recording (and writes the file) or replay */
+	UFUNCTION(BlueprintCallable, Category = "Input Recording")
+	void Stop();
+
+	static FString GetRecordingPath(const FString& Name);
+
+protected:
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:	
+	// Called every frame
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+
+	void RecordFrame();
+	void ReplayFrame();
+	bool SaveRecording() const;
+	bool LoadRecording(const FString& Path);
+
+	/** Fixed timestep and seed, shared by recording and replay */
+	void BeginDeterministicRun(int32 Seed);
+	void EndDeterministicRun();
+
+	class AMain* GetMain() const;
+
+	TArray<FRecordedInputFrame> Frames;
+	FString RecordingName;
+	int32 Seed;
+	int32 FrameIndex;
+	uint8 PreviousButtons;
+	bool bExitWhenReplayDone;
+
+	bool bPreviousUseFixedTimeStep;
+	double PreviousFixedDeltaTime;
+};
@@ -1,6 +1,7 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Item.h"
+#include "FirstProject_20.h"
 #include "Components/SphereComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "Particles/ParticleSystemComponent.h"
@@ -13,6 +14,7 @@ AItem::AItem()
 
 	CollisionVolume = CreateDefaultSubobject<USphereComponent>(TEXT("CollisionVolume"));
 	RootComponent = CollisionVolume;
+	CollisionVolume->SetCollisionResponseToChannel(ECC_Enemy, ECollisionResponse::ECR_Overlap);
 
 	Mesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Mesh"));
 	Mesh->SetupAttachment(GetRootComponent());
@@ -23,6 +25,13 @@ AItem::AItem()
 	bRotate = false;
 	RotationRate = 45.f;
 
+	// Items almost never change, so they sleep until something happens to them.
+	// The idle rotation is cosmetic and runs on every machine, no movement replication.
+	bReplicates = true;
+	SetReplicatingMovement(false);
+	NetDormancy = DORM_Initial;
+	NetCullDistanceSquared = FMath::Square(5000.f);
+
 }
 
 // Called when the game starts or when spawned
@@ -65,6 +74,14 @@ void AItem::OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* Oth
 	*/
 }
 
+void AItem::MarkItemStateChanged()
+{
+	if (HasAuthority())
+	{
+		FlushNetDormancy();
+	}
+}
+
 void AItem::OnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
 {
 	//UE_LOG(LogTemp, Warning, TEXT("Super::OnOverlapEnd()"));
@@ -38,6 +38,9 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item | ItemProperties")
 	float RotationRate;
 
+	/** Wake the item for one net update after its state changed */
+	void MarkItemStateChanged();
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
@@ -0,0 +1,22 @@
+@echo off
+rem Starts bot clients for a load test against a server running with -LoadTest.
+rem   LaunchBots.bat <Count> [ServerAddress] [ExtraArgs]
+rem   LaunchBots.bat 64 10.0.0.5 -BotTravel
+rem Set BOT_EXE to the packaged client, e.g. Binaries\Win64\FirstProject_20.exe.
+rem Each bot gets its own -BotSeed so runs with the same count replay the same way.
+
+setlocal
+if "%~1"=="" (
+	echo Usage: LaunchBots.bat ^<Count^> [ServerAddress] [ExtraArgs]
+	exit /b 1
+)
+set COUNT=%~1
+set SERVER=%~2
+if "%SERVER%"=="" set SERVER=127.0.0.1
+set EXTRA=%~3
+if "%BOT_EXE%"=="" set BOT_EXE=FirstProject_20.exe
+
+for /l %%N in (1,1,%COUNT%) do (
+	start "Bot %%N" /min "%BOT_EXE%" %SERVER%?Bot -game -nullrhi -nosound -unattended -BotSeed=%%N %EXTRA% -log=Bot%%N.log
+)
+endlocal
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LevelPrefetchSubsystem.h"
+#include "Engine/World.h"
+#include "UObject/UObjectGlobals.h"
+
+void ULevelPrefetchSubsystem::Deinitialize()
+{
+	ReleaseHeldForTravel(nullptr);
+
+	Super::Deinitialize();
+}
+
+bool ULevelPrefetchSubsystem::Reserve(int64 Bytes, int64 BudgetBytes)
+{
+	if (BytesInUse + Bytes > BudgetBytes)
+		return false;
+
+	BytesInUse += Bytes;
+	return true;
+}
+
+void ULevelPrefetchSubsystem::Release(int64 Bytes)
+{
+	BytesInUse = FMath::Max<int64>(BytesInUse - Bytes, 0);
+}
+
+void ULevelPrefetchSubsystem::HoldForTravel(UWorld* World, int64 Bytes)
+{
+	if (World == nullptr)
+		return;
+
+	if (!ReleaseAfterTravelHandle.IsValid())
+	{
+		ReleaseAfterTravelHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ULevelPrefetchSubsystem::ReleaseHeldForTravel);
+	}
+	WorldsHeldForTravel.Add(World);
+	BytesHeldForTravel += Bytes;
+}
+
+void ULevelPrefetchSubsystem::ReleaseHeldForTravel(UWorld* LoadedWorld)
+{
+	for (TWeakObjectPtr<UWorld>& World : WorldsHeldForTravel)
+	{
+		if (World.IsValid())
+		{
+			World->RemoveFromRoot();
+		}
+	}
+	WorldsHeldForTravel.Empty();
+
+	Release(BytesHeldForTravel);
+	BytesHeldForTravel = 0;
+
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(ReleaseAfterTravelHandle);
+	ReleaseAfterTravelHandle.Reset();
+}
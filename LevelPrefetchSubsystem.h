@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "LevelPrefetchSubsystem.generated.h"
+
+/**
+ * Bookkeeping shared by every ALevelTransitionVolume of a game instance: how many bytes of
+ * prefetched maps are held against the budget, and the worlds kept rooted through a level
+ * transition until the new map is up. Per game instance, so PIE sessions don't share it.
+ */
+UCLASS()
+class FIRSTPROJECT_20_API ULevelPrefetchSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Deinitialize() override;
+
+	/** Charge Bytes against BudgetBytes, false if it doesn't fit */
+	bool Reserve(int64 Bytes, int64 BudgetBytes);
+	void Release(int64 Bytes);
+
+	/** Keep an already rooted prefetched world, and its Bytes, until the next map has loaded */
+	void HoldForTravel(UWorld* World, int64 Bytes);
+
+	int64 GetBytesInUse() const { return BytesInUse; }
+
+protected:
+
+	void ReleaseHeldForTravel(UWorld* LoadedWorld);
+
+	int64 BytesInUse = 0;
+
+	TArray<TWeakObjectPtr<UWorld>> WorldsHeldForTravel;
+	int64 BytesHeldForTravel = 0;
+	FDelegateHandle ReleaseAfterTravelHandle;
+};
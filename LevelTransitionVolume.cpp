@@ -4,15 +4,22 @@
 #include "Components/BoxComponent.h"
 #include "Components/BillboardComponent.h"
 #include "Main.h"
+#include "LevelPrefetchSubsystem.h"
 #include "Components/StaticMeshComponent.h"
 #include "Particles/ParticleSystemComponent.h"
 #include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
+#include "Engine/GameInstance.h"
+#include "Misc/PackageName.h"
+#include "HAL/FileManager.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
 
 // Sets default values
 ALevelTransitionVolume::ALevelTransitionVolume()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = false;
+	PrimaryActorTick.bCanEverTick = true;
 
 	TransitionVolume = CreateDefaultSubobject<UBoxComponent>(TEXT("TransitionVolume"));
 	RootComponent = TransitionVolume;
@@ -28,6 +35,16 @@ ALevelTransitionVolume::ALevelTransitionVolume()
 
 	TransitionLevelName = "SunTemple";
 	curTime = 0.f;
+
+	bPrefetchLevel = true;
+	PrefetchRadius = 3000.f;
+	PrefetchCancelRadius = 4000.f;
+	PrefetchMemoryBudgetMB = 256;
+	PrefetchCheckInterval = 0.25f;
+
+	PrefetchBytes = 0;
+	bPrefetchRequested = false;
+	bTransitioning = false;
 }
 
 // Called when the game starts or when spawned
@@ -36,6 +53,36 @@ void ALevelTransitionVolume::BeginPlay()
 	Super::BeginPlay();
 	
 	TransitionVolume->OnComponentBeginOverlap.AddDynamic(this, &ALevelTransitionVolume::OnOverlapBegin);
+
+	// Only the distance check ticks, and not every frame
+	SetActorTickInterval(PrefetchCheckInterval);
+	SetActorTickEnabled(bPrefetchLevel);
+}
+
+ULevelPrefetchSubsystem* ALevelTransitionVolume::GetPrefetchSubsystem() const
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	return GameInstance ? GameInstance->GetSubsystem<ULevelPrefetchSubsystem>() : nullptr;
+}
+
+void ALevelTransitionVolume::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Travelling through this volume: keep the map rooted until the new world has loaded it
+	ULevelPrefetchSubsystem* Prefetch = GetPrefetchSubsystem();
+	if (bTransitioning && PrefetchedWorld.IsValid() && Prefetch)
+	{
+		Prefetch->HoldForTravel(PrefetchedWorld.Get(), PrefetchBytes);
+
+		PrefetchedWorld.Reset();
+		PrefetchBytes = 0;
+		bPrefetchRequested = false;
+	}
+	else
+	{
+		CancelPrefetch();
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
@@ -44,6 +91,117 @@ void ALevelTransitionVolume::Tick(float DeltaTime)
 	Super::Tick(DeltaTime);
 	
 	//UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), OnParticles, GetActorLocation(), FRotator(0.f), false);
+
+	APawn* Player = UGameplayStatics::GetPlayerPawn(this, 0);
+	if (!bPrefetchLevel || Player == nullptr)
+		return;
+
+	float DistanceSquared = FVector::DistSquared(Player->GetActorLocation(), GetActorLocation());
+
+	if (!bPrefetchRequested && DistanceSquared <= FMath::Square(PrefetchRadius))
+	{
+		StartPrefetch();
+	}
+	else if (bPrefetchRequested && DistanceSquared > FMath::Square(FMath::Max(PrefetchCancelRadius, PrefetchRadius)))
+	{
+		CancelPrefetch();
+	}
+}
+
+void ALevelTransitionVolume::StartPrefetch()
+{
+	if (bPrefetchRequested || TransitionLevelName.IsNone())
+		return;
+
+	UWorld* World = GetWorld();
+	if (World == nullptr)
+		return;
+
+	// Same rule as AMain::SwitchLevelForLoad, no transition to the current map
+	FString CurrentMap = World->GetMapName();
+	CurrentMap.RemoveFromStart(World->StreamingLevelsPrefix);
+	if (CurrentMap == TransitionLevelName.ToString())
+		return;
+
+	if (PrefetchPackageName.IsEmpty())
+	{
+		FString LevelName = TransitionLevelName.ToString();
+		if (FPackageName::IsValidLongPackageName(LevelName))
+		{
+			PrefetchPackageName = LevelName;
+		}
+		else if (!FPackageName::SearchForPackageOnDisk(LevelName + FPackageName::GetMapPackageExtension(), &PrefetchPackageName))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("LevelTransitionVolume: can't find map %s to prefetch"), *LevelName);
+			bPrefetchLevel = false;
+			return;
+		}
+	}
+
+	// The map file is the best estimate we have before loading, its hard dependencies come on top
+	FString FileName;
+	int64 Bytes = 0;
+	if (FPackageName::DoesPackageExist(PrefetchPackageName, nullptr, &FileName))
+	{
+		Bytes = FMath::Max<int64>(IFileManager::Get().FileSize(*FileName), 0);
+	}
+
+	ULevelPrefetchSubsystem* Prefetch = GetPrefetchSubsystem();
+	if (Prefetch == nullptr || !Prefetch->Reserve(Bytes, (int64)PrefetchMemoryBudgetMB * 1024 * 1024))
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("LevelTransitionVolume: skipping prefetch of %s, over budget"), *PrefetchPackageName);
+		return;
+	}
+
+	bPrefetchRequested = true;
+	PrefetchBytes = Bytes;
+
+	// Loads the map package and everything it imports
+	LoadPackageAsync(PrefetchPackageName, FLoadPackageAsyncDelegate::CreateUObject(this, &ALevelTransitionVolume::OnPrefetchLoaded));
+}
+
+void ALevelTransitionVolume::CancelPrefetch()
+{
+	if (!bPrefetchRequested)
+		return;
+
+	// An async package load can't be aborted on its own, OnPrefetchLoaded drops it when it arrives
+	bPrefetchRequested = false;
+	if (ULevelPrefetchSubsystem* Prefetch = GetPrefetchSubsystem())
+	{
+		Prefetch->Release(PrefetchBytes);
+	}
+	PrefetchBytes = 0;
+
+	if (PrefetchedWorld.IsValid())
+	{
+		PrefetchedWorld->RemoveFromRoot();
+	}
+	PrefetchedWorld.Reset();
+}
+
+void ALevelTransitionVolume::OnPrefetchLoaded(const FName& PackageName, UPackage* LoadedPackage, EAsyncLoadingResult::Type Result)
+{
+	if (!bPrefetchRequested || Result != EAsyncLoadingResult::Succeeded || LoadedPackage == nullptr)
+	{
+		if (bPrefetchRequested)
+		{
+			CancelPrefetch();
+		}
+		return;
+	}
+
+	// OpenLevel collects garbage before it loads the new map. The world references its levels,
+	// actors and everything they import, so rooting it keeps the whole map
+	UWorld* LoadedWorld = UWorld::FindWorldInPackage(LoadedPackage);
+	if (LoadedWorld == nullptr)
+	{
+		CancelPrefetch();
+		return;
+	}
+
+	LoadedWorld->AddToRoot();
+	PrefetchedWorld = LoadedWorld;
 }
 
 void ALevelTransitionVolume::OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult & SweepResult)
@@ -52,10 +210,12 @@ void ALevelTransitionVolume::OnOverlapBegin(UPrimitiveComponent* OverlappedCompo
 	if (OtherActor)
 	{
 		AMain* Main = Cast<AMain>(OtherActor);
-		if (Main)
+
+		// Only the server moves levels, a client opening the map itself would drop out of the game
+		if (Main && GetWorld()->GetNetMode() != NM_Client)
 		{
-			// changed
-			Main->SwitchLevelForLoad(TransitionLevelName);
+			// Only hold on to the prefetch if this really travels
+			bTransitioning = Main->SwitchLevelForLoad(TransitionLevelName);
 		}
 	}
 }
\ No newline at end of file
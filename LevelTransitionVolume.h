@@ -35,11 +35,57 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Particles")
 	float curTime;
-		
+
+	/** Start loading TransitionLevelName in the background when the player comes close */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Transition | Prefetch")
+	bool bPrefetchLevel;
+
+	/** Distance from the volume at which the prefetch starts */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Transition | Prefetch")
+	float PrefetchRadius;
+
+	/** Distance at which a started prefetch is dropped again, keep it above PrefetchRadius */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Transition | Prefetch")
+	float PrefetchCancelRadius;
+
+	/** Total size (MB) of destination maps all transition volumes may hold at once */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Transition | Prefetch")
+	int32 PrefetchMemoryBudgetMB;
+
+	/** How often the distance to the player is checked */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Transition | Prefetch")
+	float PrefetchCheckInterval;
+
+	void StartPrefetch();
+	void CancelPrefetch();
+
+	FORCEINLINE bool IsLevelPrefetched() const { return PrefetchedWorld.IsValid(); }
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	void OnPrefetchLoaded(const FName& PackageName, class UPackage* LoadedPackage, EAsyncLoadingResult::Type Result);
+
+	/** Long package name of TransitionLevelName, resolved on first prefetch */
+	FString PrefetchPackageName;
+
+	/**
+	 * World of the loaded destination map, rooted so it survives the GC that runs during
+	 * OpenLevel. Rooting the package wouldn't do, nothing in it is referenced from the package
+	 */
+	TWeakObjectPtr<UWorld> PrefetchedWorld;
+
+	class ULevelPrefetchSubsystem* GetPrefetchSubsystem() const;
+
+	/** Size charged against PrefetchMemoryBudgetMB for this volume */
+	int64 PrefetchBytes;
+
+	bool bPrefetchRequested;
+	bool bTransitioning;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
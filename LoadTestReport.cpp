@@ -0,0 +1,213 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LoadTestReport.h"
+#include "LoadTestSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "UnrealEngine.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+#include "FirstProject_20GameModeBase.h"
+#include "MainBotController.h"
+#include "Enemy.h"
+
+// Sets default values
+ALoadTestReport::ALoadTestReport()
+{
+ 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+	PrimaryActorTick.bCanEverTick = true;
+
+	Duration = 300.f;
+	OutputFile = TEXT("LoadTest/ServerReport.json");
+	bQuitWhenDone = true;
+
+	Recording = nullptr;
+}
+
+// Called when the game starts or when spawned
+void ALoadTestReport::BeginPlay()
+{
+	Super::BeginPlay();
+	
+	FParse::Value(FCommandLine::Get(), TEXT("LoadTestDuration="), Duration);
+
+	Recording = GetGameInstance()->GetSubsystem<ULoadTestSubsystem>();
+	if (Recording->bReportWritten)
+	{
+		SetActorTickEnabled(false);
+		return;
+	}
+
+	if (Recording->bStarted)
+	{
+		++Recording->LevelTravels;
+		UE_LOG(LogTemp, Display, TEXT("LoadTest: continuing in %s at %.0f seconds"), *GetWorld()->GetMapName(), Recording->Elapsed);
+		return;
+	}
+
+	Recording->bStarted = true;
+	Recording->GameThreadTimes.Reserve(FMath::CeilToInt(Duration * 60.f));
+	Recording->Samples.Reserve(FMath::CeilToInt(Duration) + 1);
+
+	UE_LOG(LogTemp, Display, TEXT("LoadTest: recording for %.0f seconds"), Duration);
+}
+
+void ALoadTestReport::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Travel keeps recording in the next map, anything else ends the test here
+	if (Recording && Recording->bStarted && !Recording->bReportWritten && EndPlayReason != EEndPlayReason::LevelTransition)
+	{
+		UE_LOG(LogTemp, Display, TEXT("LoadTest: stopped after %.0f of %.0f seconds"), Recording->Elapsed, Duration);
+		WriteReport();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Called every frame
+void ALoadTestReport::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Game thread time of the previous frame
+	Recording->GameThreadTimes.Add(FPlatformTime::ToMilliseconds(GGameThreadTime));
+
+	Recording->Elapsed += DeltaTime;
+	if (Recording->Elapsed >= Recording->NextSampleTime)
+	{
+		TakeSecondSample();
+		Recording->NextSampleTime += 1.f;
+	}
+
+	if (Recording->Elapsed >= Duration)
+	{
+		SetActorTickEnabled(false);
+		WriteReport();
+
+		if (bQuitWhenDone)
+		{
+			FPlatformMisc::RequestExit(false);
+		}
+	}
+}
+
+void ALoadTestReport::TakeSecondSample()
+{
+	FLoadTestSecondSample& Sample = Recording->Samples.AddDefaulted_GetRef();
+	Sample.Time = Recording->Elapsed;
+	Sample.Map = GetWorld()->GetMapName();
+	Sample.LiveEnemies = AEnemy::GetLiveEnemyCount();
+	Sample.UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+
+	for (TActorIterator<APlayerController> It(GetWorld()); It; ++It)
+	{
+		if (It->IsA<AMainBotController>())
+		{
+			++Sample.BotConnections;
+		}
+		else if (!It->IsLocalController())
+		{
+			++Sample.HumanConnections;
+		}
+	}
+
+	// The game mode already keeps per connection bandwidth up to date
+	if (AFirstProject_20GameModeBase* GameMode = GetWorld()->GetAuthGameMode<AFirstProject_20GameModeBase>())
+	{
+		Sample.MaxConnectionOutBytes = GameMode->MaxConnectionOutBytesPerSecond;
+		Sample.AvgConnectionOutBytes = GameMode->AvgConnectionOutBytesPerSecond;
+	}
+}
+
+void ALoadTestReport::WriteReport()
+{
+	Recording->bReportWritten = true;
+
+	TArray<float> SortedTimes = Recording->GameThreadTimes;
+	SortedTimes.Sort();
+
+	float Total = 0.f;
+	for (float Time : SortedTimes)
+	{
+		Total += Time;
+	}
+
+	int32 PeakBots = 0;
+	int32 PeakMaxOutBytes = 0;
+	uint64 PeakUsedPhysical = 0;
+	for (const FLoadTestSecondSample& Sample : Recording->Samples)
+	{
+		PeakBots = FMath::Max(PeakBots, Sample.BotConnections);
+		PeakMaxOutBytes = FMath::Max(PeakMaxOutBytes, Sample.MaxConnectionOutBytes);
+		PeakUsedPhysical = FMath::Max(PeakUsedPhysical, Sample.UsedPhysical);
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("map"), GetWorld()->GetMapName());
+	Root->SetStringField(TEXT("build"), FApp::GetBuildVersion());
+	Root->SetNumberField(TEXT("durationSeconds"), Recording->Elapsed);
+	Root->SetNumberField(TEXT("levelTravels"), Recording->LevelTravels);
+	Root->SetBoolField(TEXT("complete"), Recording->Elapsed >= Duration);
+	Root->SetNumberField(TEXT("frames"), SortedTimes.Num());
+	Root->SetNumberField(TEXT("gameThreadMsP50"), Percentile(SortedTimes, 0.50f));
+	Root->SetNumberField(TEXT("gameThreadMsP95"), Percentile(SortedTimes, 0.95f));
+	Root->SetNumberField(TEXT("gameThreadMsP99"), Percentile(SortedTimes, 0.99f));
+	Root->SetNumberField(TEXT("gameThreadMsAvg"), SortedTimes.Num() > 0 ? Total / SortedTimes.Num() : 0.f);
+	Root->SetNumberField(TEXT("peakBots"), PeakBots);
+	Root->SetNumberField(TEXT("peakConnectionOutBytesPerSecond"), PeakMaxOutBytes);
+	Root->SetNumberField(TEXT("peakUsedPhysical"), (double)PeakUsedPhysical);
+
+	// What the bots exercise, so reports from different builds can be compared fairly
+	TArray<TSharedPtr<FJsonValue>> Traffic;
+	for (const TCHAR* Name : { TEXT("Movement"), TEXT("ServerEquip"), TEXT("ServerAttack"), TEXT("ServerClaimMeleeHit"), TEXT("ClientHitCues"), TEXT("Replication") })
+	{
+		Traffic.Add(MakeShared<FJsonValueString>(Name));
+	}
+	Root->SetArrayField(TEXT("botTraffic"), Traffic);
+
+	TArray<TSharedPtr<FJsonValue>> Seconds;
+	for (const FLoadTestSecondSample& Sample : Recording->Samples)
+	{
+		TSharedRef<FJsonObject> Entry = MakeShared<FJsonObject>();
+		Entry->SetNumberField(TEXT("time"), Sample.Time);
+		Entry->SetStringField(TEXT("map"), Sample.Map);
+		Entry->SetNumberField(TEXT("bots"), Sample.BotConnections);
+		Entry->SetNumberField(TEXT("humans"), Sample.HumanConnections);
+		Entry->SetNumberField(TEXT("liveEnemies"), Sample.LiveEnemies);
+		Entry->SetNumberField(TEXT("maxConnectionOutBytesPerSecond"), Sample.MaxConnectionOutBytes);
+		Entry->SetNumberField(TEXT("avgConnectionOutBytesPerSecond"), Sample.AvgConnectionOutBytes);
+		Entry->SetNumberField(TEXT("usedPhysical"), (double)Sample.UsedPhysical);
+		Seconds.Add(MakeShared<FJsonValueObject>(Entry));
+	}
+	Root->SetArrayField(TEXT("seconds"), Seconds);
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Root, Writer);
+
+	FString Path = FPaths::Combine(FPaths::ProjectSavedDir(), OutputFile);
+	if (FFileHelper::SaveStringToFile(Json, *Path))
+	{
+		UE_LOG(LogTemp, Display, TEXT("LoadTest: report written to %s"), *Path);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("LoadTest: can't write %s"), *Path);
+	}
+}
+
+float ALoadTestReport::Percentile(const TArray<float>& SortedValues, float Fraction)
+{
+	if (SortedValues.Num() == 0)
+		return 0.f;
+
+	int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * SortedValues.Num()) - 1, 0, SortedValues.Num() - 1);
+	return SortedValues[Index];
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "LoadTestReport.generated.h"
+
+/**
+ * Server side half of a bot load test. The game mode spawns it when the server runs with
+ *   FirstProject_20 Map -server -log -LoadTest [-LoadTestDuration=300]
+ * It records game thread time every frame and, once a second, the number of bot and human
+ * connections, per connection bandwidth and memory. When the duration is up it writes one
+ * JSON report to OutputFile and shuts the server down. The recording is kept in
+ * ULoadTestSubsystem, so level travel doesn't restart it; if the server stops early the
+ * report is written from EndPlay with what was recorded.
+ *
+ * LaunchBots.bat starts the bot clients, one process each:
+ *   LaunchBots.bat <Count> [ServerAddress] [ExtraArgs, e.g. -BotTravel]
+ *
+ * Bots drive AMain on their own client, so the report covers movement, ServerEquip,
+ * ServerAttack and ServerClaimMeleeHit going up and replication plus ClientHitCues coming
+ * down. Level travel only when the bots run with -BotTravel; menus, saving and chat are not covered.
+ */
+UCLASS(NotPlaceable)
+class FIRSTPROJECT_20_API ALoadTestReport : public AActor
+{
+	GENERATED_BODY()
+	
+public:	
+	// Sets default values for this actor's properties
+	ALoadTestReport();
+
+	/** Seconds to record, -LoadTestDuration=N overrides it */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Load Test")
+	float Duration;
+
+	/** Relative to the project Saved directory */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Load Test")
+	FString OutputFile;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Load Test")
+	bool bQuitWhenDone;
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:	
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+protected:
+
+	void TakeSecondSample();
+	void WriteReport();
+
+	static float Percentile(const TArray<float>& SortedValues, float Fraction);
+
+	/** The recording, survives level travel */
+	UPROPERTY(Transient)
+	class ULoadTestSubsystem* Recording;
+};
@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "LoadTestSubsystem.generated.h"
+
+/** One second of a load test, see ALoadTestReport::TakeSecondSample */
+struct FLoadTestSecondSample
+{
+	float Time = 0.f;
+	int32 BotConnections = 0;
+	int32 HumanConnections = 0;
+	int32 LiveEnemies = 0;
+	int32 MaxConnectionOutBytes = 0;
+	int32 AvgConnectionOutBytes = 0;
+	uint64 UsedPhysical = 0;
+	FString Map;
+};
+
+/**
+ * What a load test has recorded so far. Lives on the game instance so a ServerTravel
+ * (bots run with -BotTravel) doesn't throw it away, the next map's ALoadTestReport
+ * carries on where the last one stopped.
+ */
+UCLASS()
+class FIRSTPROJECT_20_API ULoadTestSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	bool bStarted = false;
+	bool bReportWritten = false;
+
+	float Elapsed = 0.f;
+	float NextSampleTime = 0.f;
+	int32 LevelTravels = 0;
+
+	TArray<float> GameThreadTimes;
+	TArray<FLoadTestSecondSample> Samples;
+};
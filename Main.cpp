@@ -1,9 +1,13 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Main.h"
+#include "FirstProject_20.h"
+#include "FirstProjectTrace.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Camera/CameraComponent.h"
 #include "Engine/World.h"
+#include "Engine/GameInstance.h"
+#include "EngineUtils.h"
 #include "Components/InputComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
@@ -12,18 +16,34 @@
 #include "Components/SkeletalMeshComponent.h"
 #include "Animation/AnimInstance.h"
 #include "Kismet/GameplayStatics.h"
+#include "FirstProjectCosmetics.h"
 #include "Sound/SoundCue.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Enemy.h"
 #include "MainPlayerController.h"
 #include "FirstSaveGame.h"
 #include "ItemStorage.h"
+#include "TravelStateSubsystem.h"
+#include "InputRecorderComponent.h"
+#include "AttackTokenComponent.h"
+#include "RandomStreamSubsystem.h"
+#include "HitRewindSubsystem.h"
+#include "MainMovementComponent.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 
 
 //#include "TimerManager.h" 
 
+DECLARE_CYCLE_STAT(TEXT("Main Tick"), STAT_MainTick, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Main UpdateCombatTarget"), STAT_MainUpdateCombatTarget, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Main SaveGame"), STAT_MainSaveGame, STATGROUP_FirstProject);
+DECLARE_CYCLE_STAT(TEXT("Main LoadGame"), STAT_MainLoadGame, STATGROUP_FirstProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("UpdateCombatTarget Calls"), STAT_UpdateCombatTargetCalls, STATGROUP_FirstProject);
+
 // Sets default values
-AMain::AMain()
+AMain::AMain(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UMainMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
  	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
@@ -45,6 +65,10 @@ AMain::AMain()
 	// the controller orientation
 	FollowCamera->bUsePawnControlRotation = false;
 
+	InputRecorder = CreateDefaultSubobject<UInputRecorderComponent>(TEXT("InputRecorder"));
+
+	AttackTokens = CreateDefaultSubobject<UAttackTokenComponent>(TEXT("AttackTokens"));
+
 	// Set our turn rates for input 
 	BaseTurnRate = 65.f;
 	BaseLookupRate = 65.f;
@@ -64,6 +88,7 @@ AMain::AMain()
 
 	MaxHealth = 100.f;
 	Health = 65.f;
+	HealthPacked = 0;
 	MaxStamina = 150.f;
 	Stamina = 120.f;
 	Coins = 0;
@@ -89,6 +114,44 @@ AMain::AMain()
 
 	bMovingForward = false;
 	bMovingRight = false;
+
+	bSaveInBackgroundOnTravel = true;
+	bStateRestored = false;
+
+	MeleeHitTolerance = 50.f;
+
+	// Whole units and byte rotations are plenty for a third person character
+	GetReplicatedMovement_Mutable().LocationQuantizationLevel = EVectorQuantization::RoundWholeNumber;
+	GetReplicatedMovement_Mutable().VelocityQuantizationLevel = EVectorQuantization::RoundWholeNumber;
+	GetReplicatedMovement_Mutable().RotationQuantizationLevel = ERotatorQuantization::ByteComponents;
+}
+
+void AMain::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Push model: only compared when a setter marked them dirty
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AMain, MovementStatus, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AMain, HealthPacked, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AMain, MaxHealth, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AMain, EquippedWeapon, Params);
+
+	// The owner predicts its own swings
+	FDoRepLifetimeParams SkipOwnerParams;
+	SkipOwnerParams.bIsPushBased = true;
+	SkipOwnerParams.Condition = COND_SkipOwner;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AMain, bAttacking, SkipOwnerParams);
+
+	// Stamina and targeting only matter to the HUD of the owning player
+	FDoRepLifetimeParams OwnerParams;
+	OwnerParams.bIsPushBased = true;
+	OwnerParams.Condition = COND_OwnerOnly;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AMain, Stamina, OwnerParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AMain, MaxStamina, OwnerParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AMain, StaminaStatus, OwnerParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AMain, CombatTarget, OwnerParams);
 }
 
 // Called when the game starts or when spawned
@@ -98,125 +161,44 @@ void AMain::BeginPlay()
 
 	MainPlayerController = Cast<AMainPlayerController>(GetController());
 
-	FString Map = GetWorld()->GetMapName();
-	Map.RemoveFromStart(GetWorld()->StreamingLevelsPrefix);
-
-	LoadGameNoSwitch();	
+	SetHealth(Health);
 }
 
-// Called every frame
-void AMain::Tick(float DeltaTime)
+void AMain::PossessedBy(AController* NewController)
 {
-	Super::Tick(DeltaTime);
+	Super::PossessedBy(NewController);
 
-	if (MovementStatus == EMovementStatus::EMS_Dead)
+	// Only the server restores, and only once; clients get the result through replication
+	if (bStateRestored || !HasAuthority())
 		return;
 
-	float DeltaStamina = StaminaDrainRate * DeltaTime;
+	bStateRestored = true;
 
-	switch (StaminaStatus)
+	// Coming from a level transition the player's state is already in memory. Otherwise
+	// read the save slot, but only for our own player, the disk save isn't a remote player's
+	UTravelStateSubsystem* TravelState = GetGameInstance() ? GetGameInstance()->GetSubsystem<UTravelStateSubsystem>() : nullptr;
+	if (TravelState && TravelState->ApplyToCharacter(this))
 	{
-		case EStaminaStatus::ESS_Normal:
-			if (bShiftKeyDown)
-			{
-				if (Stamina - DeltaStamina <= MinSprintStamina)
-				{
-					SetStaminaStatus(EStaminaStatus::ESS_BelowMinimum);
-					Stamina -= DeltaStamina;
-				}
-				else
-				{
-					Stamina -= DeltaStamina;
-				}
+		ResetStateAfterLoad();
+	}
+	else if (NewController && NewController->IsLocalController())
+	{
+		LoadGameNoSwitch();
+	}
+}
 
-				if (bMovingForward || bMovingRight)
-				{
-					SetMovementStatus(EMovementStatus::EMS_Sprinting);
-				}	
-				else
-				{
-					SetMovementStatus(EMovementStatus::EMS_Normal);
-				}
-			}
-			else // Shift key up
-			{
-				if (Stamina + DeltaStamina >= MaxStamina)
-				{
-					Stamina = MaxStamina;
-				}
-				else
-				{
-					Stamina += DeltaStamina;
-				}
-				SetMovementStatus(EMovementStatus::EMS_Normal);
-			}
-		break;
+// Called every frame
+void AMain::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MainTick);
+	CSV_SCOPED_TIMING_STAT(FirstProject, MainTick);
 
-		case EStaminaStatus::ESS_BelowMinimum:
-			if (bShiftKeyDown)
-			{
-				if (Stamina - DeltaStamina <= 0.f)
-				{
-					SetStaminaStatus(EStaminaStatus::ESS_Exhausted);
-					Stamina = 0;
-					SetMovementStatus(EMovementStatus::EMS_Normal);
-				}
-				else
-				{
-					Stamina -= DeltaStamina;
-					if (bMovingForward || bMovingRight)
-					{
-						SetMovementStatus(EMovementStatus::EMS_Sprinting);
-					}
-					else
-					{
-						SetMovementStatus(EMovementStatus::EMS_Normal);
-					}
-					//SetMovementStatus(EMovementStatus::EMS_Sprinting);
-				}
-			}
-			else // Shift key up
-			{
-				if (Stamina + DeltaStamina >= MinSprintStamina)
-				{
-					SetStaminaStatus(EStaminaStatus::ESS_Normal);
-					Stamina += DeltaStamina;
-				}
-				else
-				{
-					Stamina += DeltaStamina;
-				}
-				SetMovementStatus(EMovementStatus::EMS_Normal);
-			}
-		break;
-		case EStaminaStatus::ESS_Exhausted:
-			if (bShiftKeyDown)
-			{
-				Stamina = 0.f;
-			}
-			else // Shift key up
-			{
-				SetStaminaStatus(EStaminaStatus::ESS_ExhaustedRecovering);
-				Stamina += DeltaStamina;
-			}
-			SetMovementStatus(EMovementStatus::EMS_Normal);
-		break;
-		case EStaminaStatus::ESS_ExhaustedRecovering:
-			if (Stamina + DeltaStamina >= MinSprintStamina)
-			{
-				SetStaminaStatus(EStaminaStatus::ESS_Normal);
-				Stamina += DeltaStamina;
-			}
-			else
-			{
-				Stamina += DeltaStamina;
-			}
-			SetMovementStatus(EMovementStatus::EMS_Normal);
-		break;
+	Super::Tick(DeltaTime);
 
-		default:
-			;
-	}
+	if (MovementStatus == EMovementStatus::EMS_Dead)
+		return;
+
+	// Sprint and stamina run in UMainMovementComponent, once per move
 
 	// Ready to Interp & CombatTarget is valid, 
 	if (bInterpToEnemy && CombatTarget)
@@ -335,8 +317,13 @@ void AMain::LMBDown()
 		AWeapon * Weapon = Cast<AWeapon>(ActiveOverlappingItem);
 		if (Weapon)
 		{
+			// Equip locally right away, the server does the same once it agrees
 			Weapon->Equip(this);
 			SetActiveOverlappingItem(nullptr);
+			if (!HasAuthority())
+			{
+				ServerEquip(Weapon);
+			}
 		}
 	}
 	else if(EquippedWeapon)
@@ -366,17 +353,19 @@ void AMain::DecrementHealth(float Amount)
 {
 	if (Health - Amount <= 0.f)
 	{	
-		Health = 0.f;
+		SetHealth(0.f);
 		Die();
 	}
 	else
 	{
-		Health -= Amount;
+		SetHealth(Health - Amount);
 	}
 }
 
 void AMain::Die()
 {
+	FIRSTPROJECT_TRACE(Death, this);
+
 	bDieDeathEnd = true;
 
 	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
@@ -401,7 +390,7 @@ void AMain::DeathEnd()
 {
 	GetMesh()->bPauseAnims = true;
 	GetMesh()->bNoSkeletonUpdate = true;
-	bAttacking = true;
+	SetAttacking(true);
 	bDieDeathEnd = false;
 }
 
@@ -414,36 +403,165 @@ void AMain::IncrementHealth(float Amount)
 {
 	if (Health + Amount >= MaxHealth)
 	{
-		Health = MaxHealth;
+		SetHealth(MaxHealth);
 	}
 	else
 	{
-		Health += Amount;
+		SetHealth(Health + Amount);
 	}
 }
 
-void AMain::SetMovementStatus(EMovementStatus Status)
+void AMain::SetHealth(float NewHealth)
 {
-	MovementStatus = Status;
+	Health = NewHealth;
 
-	if (MovementStatus == EMovementStatus::EMS_Sprinting)
+	uint8 NewPacked = MaxHealth > 0.f ? (uint8)FMath::RoundToInt(FMath::Clamp(Health / MaxHealth, 0.f, 1.f) * 255.f) : 0;
+	if (NewPacked != HealthPacked)
 	{
-		GetCharacterMovement()->MaxWalkSpeed = SprintingSpeed;
+		HealthPacked = NewPacked;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AMain, HealthPacked, this);
+	}
+}
+
+void AMain::OnRep_HealthPacked()
+{
+	Health = (HealthPacked / 255.f) * MaxHealth;
+}
+
+void AMain::SetAttacking(bool bNewAttacking)
+{
+	if (bAttacking != bNewAttacking)
+	{
+		bAttacking = bNewAttacking;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AMain, bAttacking, this);
+	}
+}
+
+bool AMain::ServerClaimMeleeHit_Validate(AEnemy* Enemy, FVector_NetQuantize HitLocation, float ClientTime)
+{
+	return true;
+}
+
+void AMain::ServerClaimMeleeHit_Implementation(AEnemy* Enemy, FVector_NetQuantize HitLocation, float ClientTime)
+{
+	if (!Enemy || !Enemy->Alive() || !EquippedWeapon || MovementStatus == EMovementStatus::EMS_Dead) return;
+
+	// Only during a swing the server is playing as well, and once per enemy per swing
+	if (!bAttacking || SwingHitEnemies.Contains(Enemy))
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("Rejected melee hit on %s from %s outside a swing"), *Enemy->GetName(), *GetName());
+		return;
+	}
+
+	UHitRewindSubsystem* HitRewind = GetWorld()->GetSubsystem<UHitRewindSubsystem>();
+
+	// Don't let a client rewind past the oldest sample we still have
+	const float ServerTime = UHitRewindSubsystem::GetRewindTime(GetWorld());
+	const float OldestTime = HitRewind ? HitRewind->GetOldestTime() : ServerTime;
+	ClientTime = FMath::Clamp(ClientTime, OldestTime, ServerTime);
+
+	// The weapon can't reach further from us than the tolerance either
+	const float Reach = GetCapsuleComponent()->GetScaledCapsuleHalfHeight() * 2.f + MeleeHitTolerance;
+	if (FVector::DistSquared(HitLocation, GetActorLocation()) > FMath::Square(Reach)) return;
+
+	if (HitRewind && HitRewind->ValidateHit(Enemy, HitLocation, ClientTime, MeleeHitTolerance))
+	{
+		SwingHitEnemies.Add(Enemy);
+		EquippedWeapon->ApplyHit(Enemy, HitLocation);
 	}
 	else
 	{
-		GetCharacterMovement()->MaxWalkSpeed = RunnungSpeed;
+		UE_LOG(LogTemp, Verbose, TEXT("Rejected melee hit on %s from %s"), *Enemy->GetName(), *GetName());
 	}
 }
 
+bool AMain::ServerEquip_Validate(AWeapon* Weapon)
+{
+	return true;
+}
+
+void AMain::ServerEquip_Implementation(AWeapon* Weapon)
+{
+	if (!Weapon || MovementStatus == EMovementStatus::EMS_Dead) return;
+
+	// Has to be lying around and within our reach, not in someone else's hand
+	if (Weapon->GetAttachParentActor() || !Weapon->IsOverlappingActor(this))
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("Rejected equip of %s from %s"), *Weapon->GetName(), *GetName());
+		return;
+	}
+
+	Weapon->Equip(this);
+}
+
+void AMain::ServerAttack_Implementation()
+{
+	if (EquippedWeapon)
+	{
+		Attack();
+	}
+}
+
+void AMain::SetStaminaStatus(EStaminaStatus Status)
+{
+	if (StaminaStatus != Status)
+	{
+		StaminaStatus = Status;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AMain, StaminaStatus, this);
+	}
+}
+
+void AMain::SetCombatTarget(AEnemy* Target)
+{
+	if (CombatTarget != Target)
+	{
+		CombatTarget = Target;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AMain, CombatTarget, this);
+	}
+}
+
+void AMain::SetMovementStatus(EMovementStatus Status)
+{
+	if (MovementStatus != Status)
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(AMain, MovementStatus, this);
+	}
+	MovementStatus = Status;
+}
+
 void AMain::ShiftKeyDown()
 {
 	bShiftKeyDown = true;
+	GetMainMovement()->SetWantsToSprint(true);
 }
 
 void AMain::ShiftKeyUp()
 {
 	bShiftKeyDown = false;
+	GetMainMovement()->SetWantsToSprint(false);
+}
+
+UMainMovementComponent* AMain::GetMainMovement() const
+{
+	return Cast<UMainMovementComponent>(GetCharacterMovement());
+}
+
+void AMain::OnRep_Stamina(float OldStamina)
+{
+	// The owner predicts its own stamina, only take the server's when we're clearly off
+	if (IsLocallyControlled() && FMath::Abs(Stamina - OldStamina) <= GetMainMovement()->StaminaCorrectionThreshold)
+	{
+		Stamina = OldStamina;
+	}
+}
+
+void AMain::OnRep_StaminaStatus(EStaminaStatus OldStatus)
+{
+	// Derived from the predicted stamina on the owner, the server's is a round trip behind
+	if (IsLocallyControlled())
+	{
+		StaminaStatus = OldStatus;
+	}
 }
 
 void AMain::ShowPickupLocations()
@@ -463,26 +581,34 @@ void AMain::ShowPickupLocations()
 
 void AMain::SetEquippedWeapon(AWeapon* WeaponToSet)
 {
-	if (EquippedWeapon)
+	// Replicated actors only go away on the server, clients get the destroy from it
+	if (EquippedWeapon && EquippedWeapon != WeaponToSet && HasAuthority())
 	{
 		EquippedWeapon->Destroy();
 	}
 
 	EquippedWeapon = WeaponToSet;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AMain, EquippedWeapon, this);
 }
 
 void AMain::Attack()
 {
-	if (!bAttacking && MovementStatus != EMovementStatus::EMS_Dead)
+	if (!bAttacking && EquippedWeapon && MovementStatus != EMovementStatus::EMS_Dead)
 	{
-		bAttacking = true;
+		SetAttacking(true);
 		SetInterpToEnemy(true);
+		SwingHitEnemies.Reset();
+
+		if (!HasAuthority() && IsLocallyControlled())
+		{
+			ServerAttack();
+		}
 
 		UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
 
 		if (AnimInstance && CombatMontage)
 		{
-			int32 Section = FMath::RandRange(0, 1);
+			int32 Section = URandomStreamSubsystem::Get(this, ERandomStreamId::ERS_Combat).RandRange(0, 1);
 
 			switch (Section)
 			{
@@ -507,7 +633,7 @@ void AMain::Attack()
 
 void AMain::AttackEnd() // CombatMontage -> Notify(EndAttacking) -> MainAnim_BP -> Called this function
 {
-	bAttacking = false;
+	SetAttacking(false);
 	SetInterpToEnemy(false);
 
 	if (bLMBDown)
@@ -519,7 +645,7 @@ void AMain::AttackEnd() // CombatMontage -> Notify(EndAttacking) -> MainAnim_BP
 void AMain::PlaySwingSound()
 {
 	if(EquippedWeapon->SwingSound)
-		UGameplayStatics::PlaySound2D(this, EquippedWeapon->SwingSound);
+		FFirstProjectCosmetics::PlaySound2D(this, EquippedWeapon->SwingSound);
 }
 
 void AMain::SetInterpToEnemy(bool Interp)
@@ -529,9 +655,13 @@ void AMain::SetInterpToEnemy(bool Interp)
 
 float AMain::TakeDamage(float DamageAmount, struct FDamageEvent const & DamageEvent, class AController * EventInstigator, AActor * DamageCauser)
 {
+	INC_DWORD_STAT(STAT_DamageEvents);
+	CSV_CUSTOM_STAT(FirstProject, DamageEvents, 1, ECsvCustomStatOp::Accumulate);
+	FIRSTPROJECT_TRACE(Damage, this, DamageCauser, DamageAmount);
+
 	if (Health - DamageAmount <= 0.f)
 	{
-		Health = 0.f;
+		SetHealth(0.f);
 		Die();
 		if (DamageCauser)
 		{
@@ -545,7 +675,7 @@ float AMain::TakeDamage(float DamageAmount, struct FDamageEvent const & DamageEv
 	}
 	else
 	{
-		Health -= DamageAmount;
+		SetHealth(Health - DamageAmount);
 	}
 
 	return DamageAmount;
@@ -553,6 +683,9 @@ float AMain::TakeDamage(float DamageAmount, struct FDamageEvent const & DamageEv
 
 void AMain::UpdateCombatTarget()
 {
+	SCOPE_CYCLE_COUNTER(STAT_MainUpdateCombatTarget);
+	INC_DWORD_STAT(STAT_UpdateCombatTargetCalls);
+
 	TArray<AActor*> OverlappingActors;
 	GetOverlappingActors(OverlappingActors, EnemyFilter);
 
@@ -604,12 +737,13 @@ void AMain::SwitchLevel(FName LevelName)
 		FName CurrentLevelName(*CurrentLevel);
 		if (CurrentLevelName != LevelName )
 		{			
+			FIRSTPROJECT_TRACE(LevelTransition, CurrentLevelName, LevelName);
 			UGameplayStatics::OpenLevel(World, LevelName);
 		}
 	}
 }
 
-void AMain::SwitchLevelForLoad(FName LevelName)
+bool AMain::SwitchLevelForLoad(FName LevelName)
 {
 	UWorld* World = GetWorld();
 	if (World)
@@ -619,49 +753,121 @@ void AMain::SwitchLevelForLoad(FName LevelName)
 		FName CurrentLevelName(*CurrentLevel);
 		if (CurrentLevelName != LevelName && LevelName.ToString() != TEXT(""))
 		{	
-			//
-			SaveGame();
-			UGameplayStatics::OpenLevel(World, LevelName);		
-			LoadGameNoSwitch();
+			FIRSTPROJECT_TRACE(LevelTransition, CurrentLevelName, LevelName);
+
+			// Everyone travels, hand each player's state to their next AMain in memory. It picks it up in PossessedBy
+			UTravelStateSubsystem* TravelState = GetGameInstance() ? GetGameInstance()->GetSubsystem<UTravelStateSubsystem>() : nullptr;
+			if (TravelState)
+			{
+				for (TActorIterator<AMain> It(World); It; ++It)
+				{
+					TravelState->StoreFromCharacter(*It);
+				}
+				if (bSaveInBackgroundOnTravel)
+				{
+					TravelState->SaveInBackground(this);
+				}
+			}
+			else
+			{
+				SaveGame();
+			}
+
+			if (World->GetNetMode() == NM_DedicatedServer || World->GetNetMode() == NM_ListenServer)
+			{
+				// Take the connected clients along instead of dropping them
+				World->ServerTravel(LevelName.ToString());
+			}
+			else
+			{
+				UGameplayStatics::OpenLevel(World, LevelName);
+			}
+			return true;
 		}
 	}
+	return false;
 }
 
 void AMain::SaveGame()
 {
+	SCOPE_CYCLE_COUNTER(STAT_MainSaveGame);
+	CSV_SCOPED_TIMING_STAT(FirstProject, SaveGame);
+	LLM_SCOPE_BYTAG(FirstProject_SaveData);
+	FIRSTPROJECT_TRACE(Save, this);
+
 	if (Health > 0.f)
 	{
 		UFirstSaveGame* SaveGameInstance = Cast<UFirstSaveGame>(UGameplayStatics::CreateSaveGameObject(UFirstSaveGame::StaticClass()));
 
-		SaveGameInstance->CharacterStats.Health = Health;
-		SaveGameInstance->CharacterStats.MaxHealth = MaxHealth;
-		SaveGameInstance->CharacterStats.Stamina = Stamina;
-		SaveGameInstance->CharacterStats.MaxStamina = MaxStamina;
-		SaveGameInstance->CharacterStats.Coins = Coins;
+		WriteCharacterStats(SaveGameInstance->CharacterStats);
 
-		// Get correct MapName
-		FString MapName = GetWorld()->GetMapName();
-		//UE_LOG(LogTemp, Warning, TEXT("MapName: %s"), *MapName);
-		MapName.RemoveFromStart(GetWorld()->StreamingLevelsPrefix);
-		//UE_LOG(LogTemp, Warning, TEXT("MapName: %s"), *MapName);
+		UGameplayStatics::SaveGameToSlot(SaveGameInstance, SaveGameInstance->PlayerName, SaveGameInstance->UserIndex);
+	}	
+}
 
-		// save MapName
-		SaveGameInstance->CharacterStats.LevelName = MapName;
+void AMain::WriteCharacterStats(FCharacterStats& Stats)
+{
+	Stats.Health = Health;
+	Stats.MaxHealth = MaxHealth;
+	Stats.Stamina = Stamina;
+	Stats.MaxStamina = MaxStamina;
+	Stats.Coins = Coins;
 
-		if (EquippedWeapon)
-		{
-			SaveGameInstance->CharacterStats.WeaponName = EquippedWeapon->Name;
-		}
+	// Get correct MapName
+	FString MapName = GetWorld()->GetMapName();
+	//UE_LOG(LogTemp, Warning, TEXT("MapName: %s"), *MapName);
+	MapName.RemoveFromStart(GetWorld()->StreamingLevelsPrefix);
+	//UE_LOG(LogTemp, Warning, TEXT("MapName: %s"), *MapName);
 
-		SaveGameInstance->CharacterStats.Location = GetActorLocation();
-		SaveGameInstance->CharacterStats.Rotation = GetActorRotation();
+	// save MapName
+	Stats.LevelName = MapName;
 
-		UGameplayStatics::SaveGameToSlot(SaveGameInstance, SaveGameInstance->PlayerName, SaveGameInstance->UserIndex);
-	}	
+	if (EquippedWeapon)
+	{
+		Stats.WeaponName = EquippedWeapon->Name;
+	}
+
+	Stats.Location = GetActorLocation();
+	Stats.Rotation = GetActorRotation();
+}
+
+void AMain::ReadCharacterStats(const FCharacterStats& Stats)
+{
+	MaxHealth = Stats.MaxHealth;
+	SetHealth(Stats.Health);
+	Stamina = Stats.Stamina;
+	MaxStamina = Stats.MaxStamina;
+	Coins = Stats.Coins;
+
+	MARK_PROPERTY_DIRTY_FROM_NAME(AMain, MaxHealth, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AMain, Stamina, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AMain, MaxStamina, this);
+}
+
+void AMain::ResetStateAfterLoad()
+{
+	// It makes character moves
+	SetMovementStatus(EMovementStatus::EMS_Normal);
+	GetMesh()->bPauseAnims = false;
+	GetMesh()->bNoSkeletonUpdate = false;
+	SetAttacking(false);
+	SetInterpToEnemy(false);
+
+	if (MainPlayerController)
+	{
+		MainPlayerController->bShowMouseCursor = false;
+		FInputModeGameOnly InputModeGameOnly;
+		MainPlayerController->SetInputMode(InputModeGameOnly);
+	}
 }
 
 void AMain::LoadGame(bool SetPosition)
 {
+	SCOPE_CYCLE_COUNTER(STAT_MainLoadGame);
+	CSV_SCOPED_TIMING_STAT(FirstProject, LoadGame);
+	LLM_SCOPE_BYTAG(FirstProject_SaveData);
+	FIRSTPROJECT_TRACE(Load, this);
+
 	if (bDieDeathEnd)
 		return;
 
@@ -683,16 +889,18 @@ void AMain::LoadGame(bool SetPosition)
 
 
 	// Data -> Character
-	Health = LoadGameInstance->CharacterStats.Health;
-	MaxHealth = LoadGameInstance->CharacterStats.MaxHealth;
-	Stamina = LoadGameInstance->CharacterStats.Stamina;
-	MaxStamina = LoadGameInstance->CharacterStats.MaxStamina;
-	Coins = LoadGameInstance->CharacterStats.Coins;
+	ReadCharacterStats(LoadGameInstance->CharacterStats);
 
 	// Load weapon 
-	AItemStorage * Weapons = GetWorld()->SpawnActor<AItemStorage>(WeaponStorage);
+	AItemStorage * Weapons = nullptr;
+	{
+		LLM_SCOPE_BYTAG(FirstProject_Items);
+		Weapons = GetWorld()->SpawnActor<AItemStorage>(WeaponStorage);
+	}
 	if (Weapons)
 	{
+		LLM_SCOPE_BYTAG(FirstProject_Weapons);
+
 		FString WeaponName = LoadGameInstance->CharacterStats.WeaponName;
 
 		AWeapon* WeaponToEquip = GetWorld()->SpawnActor<AWeapon>(Weapons->WeaponMap[WeaponName]);
@@ -709,20 +917,16 @@ void AMain::LoadGame(bool SetPosition)
 		SetActorRotation(LoadGameInstance->CharacterStats.Rotation);
 	}
 
-	// It makes character moves
-	SetMovementStatus(EMovementStatus::EMS_Normal);
-	GetMesh()->bPauseAnims = false;
-	GetMesh()->bNoSkeletonUpdate = false;
-	bAttacking = false;
-	SetInterpToEnemy(false);	
-
-	MainPlayerController->bShowMouseCursor = false;
-	FInputModeGameOnly InputModeGameOnly;
-	MainPlayerController->SetInputMode(InputModeGameOnly);
+	ResetStateAfterLoad();
 }
 
 void AMain::LoadGameNoSwitch()
 {
+	SCOPE_CYCLE_COUNTER(STAT_MainLoadGame);
+	CSV_SCOPED_TIMING_STAT(FirstProject, LoadGame);
+	LLM_SCOPE_BYTAG(FirstProject_SaveData);
+	FIRSTPROJECT_TRACE(Load, this);
+
 	if (bDieDeathEnd)
 		return;
 
@@ -733,16 +937,18 @@ void AMain::LoadGameNoSwitch()
 	LoadGameInstance = Cast<UFirstSaveGame>(UGameplayStatics::LoadGameFromSlot(LoadGameInstance->PlayerName, LoadGameInstance->UserIndex));
 
 	// Data -> Character
-	Health = LoadGameInstance->CharacterStats.Health;
-	MaxHealth = LoadGameInstance->CharacterStats.MaxHealth;
-	Stamina = LoadGameInstance->CharacterStats.Stamina;
-	MaxStamina = LoadGameInstance->CharacterStats.MaxStamina;
-	Coins = LoadGameInstance->CharacterStats.Coins;
+	ReadCharacterStats(LoadGameInstance->CharacterStats);
 
 	// Load weapon 
-	AItemStorage * Weapons = GetWorld()->SpawnActor<AItemStorage>(WeaponStorage);
+	AItemStorage * Weapons = nullptr;
+	{
+		LLM_SCOPE_BYTAG(FirstProject_Items);
+		Weapons = GetWorld()->SpawnActor<AItemStorage>(WeaponStorage);
+	}
 	if (Weapons)
 	{
+		LLM_SCOPE_BYTAG(FirstProject_Weapons);
+
 		FString WeaponName = LoadGameInstance->CharacterStats.WeaponName;
 
 		AWeapon* WeaponToEquip = GetWorld()->SpawnActor<AWeapon>(Weapons->WeaponMap[WeaponName]);
@@ -752,14 +958,5 @@ void AMain::LoadGameNoSwitch()
 		}
 	}
 
-	// my 
-	SetMovementStatus(EMovementStatus::EMS_Normal);
-	GetMesh()->bPauseAnims = false;
-	GetMesh()->bNoSkeletonUpdate = false;
-	bAttacking = false;
-	SetInterpToEnemy(false);
-
-	MainPlayerController->bShowMouseCursor = false;
-	FInputModeGameOnly InputModeGameOnly;
-	MainPlayerController->SetInputMode(InputModeGameOnly);
+	ResetStateAfterLoad();
 }
\ No newline at end of file
@@ -34,7 +34,7 @@ class FIRSTPROJECT_20_API AMain : public ACharacter
 
 public:
 	// Sets default values for this character's properties
-	AMain();
+	AMain(const FObjectInitializer& ObjectInitializer);
 
 	UPROPERTY(EditDefaultsOnly, Category = "SaveData")
 	TSubclassOf<class AItemStorage> WeaponStorage;
@@ -62,13 +62,16 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void ShowPickupLocations();
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Enums")
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Replicated, Category = "Enums")
 	EMovementStatus MovementStatus;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Enums")
+	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, ReplicatedUsing = OnRep_StaminaStatus, Category = "Enums")
 	EStaminaStatus StaminaStatus;
 
-	FORCEINLINE void SetStaminaStatus(EStaminaStatus Status) { StaminaStatus = Status; }
+	void SetStaminaStatus(EStaminaStatus Status);
+
+	UFUNCTION()
+	void OnRep_StaminaStatus(EStaminaStatus OldStatus);
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
 	float StaminaDrainRate;
@@ -80,17 +83,19 @@ public:
 	bool bInterpToEnemy;
 	void SetInterpToEnemy(bool Interp);
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Combat")
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Replicated, Category = "Combat")
 	class AEnemy* CombatTarget;
 
-	FORCEINLINE void SetCombatTarget(AEnemy* Target) { CombatTarget = Target; };
+	void SetCombatTarget(AEnemy* Target);
 
 	FRotator GetLookAtRotationYaw(FVector Target);
 
 
-	/** Set movement status and running speed */
+	/** Set movement status, the speed for it comes from UMainMovementComponent::GetMaxSpeed */
 	void SetMovementStatus(EMovementStatus Status);
 
+	class UMainMovementComponent* GetMainMovement() const;
+
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category ="Running")
 	float RunnungSpeed;
 
@@ -114,6 +119,14 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class UCameraComponent * FollowCamera;
 
+	/** Records and replays the input stream for deterministic perf runs */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Input")
+	class UInputRecorderComponent* InputRecorder;
+
+	/** Limits how many enemies attack at once, the rest wait on a ring around us */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Combat")
+	class UAttackTokenComponent* AttackTokens;
+
 	/** Base turn rates to scale turning functions for the camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
 	float BaseTurnRate;
@@ -125,18 +138,37 @@ public:
 	/* Player Stats
 	/*
 	*/
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Player Stats")
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Replicated, Category = "Player Stats")
 	float MaxHealth;
 	
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Player Stats")
+	/** Server value, clients rebuild it from HealthPacked. Change it through SetHealth */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Player Stats")
 	float Health;
 
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Player Stats")
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Replicated, Category = "Player Stats")
 	float MaxStamina;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Player Stats")
+	/** Only the owning client sees it, and predicts it in UMainMovementComponent */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, ReplicatedUsing = OnRep_Stamina, Category = "Player Stats")
 	float Stamina;
 
+	UFUNCTION()
+	void OnRep_Stamina(float OldStamina);
+
+	/** Health / MaxHealth in a byte, what actually goes over the network */
+	UPROPERTY(ReplicatedUsing = OnRep_HealthPacked)
+	uint8 HealthPacked;
+
+	UFUNCTION()
+	void OnRep_HealthPacked();
+
+	/**
+	 * The only way to change Health, it keeps HealthPacked in step and marks it dirty for
+	 * push model. BeginPlay calls it once for the value the blueprint was edited to
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Player Stats")
+	void SetHealth(float NewHealth);
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Player Stats")
 	int32 Coins;
 
@@ -164,6 +196,11 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	/** Server: restore the player's travel state or save once we know whose pawn this is */
+	virtual void PossessedBy(AController* NewController) override;
+
+	bool bStateRestored;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -171,6 +208,8 @@ public:
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	/** Called for forwards/backwards input */
 	void MoveForward(float Value);
 
@@ -201,7 +240,7 @@ public:
 	FORCEINLINE class USpringArmComponent * GetCameraBoom() const { return CameraBoom; };
 	FORCEINLINE class UCameraComponent * GetFollowCamera() const { return FollowCamera; };
 
-	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Items")
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Replicated, Category = "Items")
 	class AWeapon* EquippedWeapon;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Items")
@@ -213,9 +252,30 @@ public:
 
 	FORCEINLINE void SetActiveOverlappingItem(AItem * Item) { ActiveOverlappingItem = Item; }
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Anims")
+	/** Slack added to the enemy capsule when the server checks a claimed melee hit */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Combat")
+	float MeleeHitTolerance;
+
+	/** The client's weapon hit an enemy, the server checks it against where that enemy was at ClientTime. Unreliable, a late claim would be rejected anyway */
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerClaimMeleeHit(AEnemy* Enemy, FVector_NetQuantize HitLocation, float ClientTime);
+
+	/** The owning client picked up Weapon, the server equips it if we're actually standing on it */
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerEquip(AWeapon* Weapon);
+
+	/** The owning client started a swing, the server plays it too so hit claims have a swing to land in */
+	UFUNCTION(Server, Reliable)
+	void ServerAttack();
+
+	/** Enemies already hit by the current swing, each can only be claimed once */
+	TArray<TWeakObjectPtr<AEnemy>> SwingHitEnemies;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Replicated, Category = "Anims")
 	bool bAttacking;
 
+	void SetAttacking(bool bNewAttacking);
+
 	void Attack();
 
 	UFUNCTION(BlueprintCallable)
@@ -238,7 +298,8 @@ public:
 
 
 	void SwitchLevel(FName LevelName);
-	void SwitchLevelForLoad(FName LevelName);
+	/** True if it started travelling, false for the current map or no name */
+	bool SwitchLevelForLoad(FName LevelName);
 
 	UFUNCTION(BlueprintCallable)
 	void SaveGame();
@@ -249,5 +310,18 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void LoadGameNoSwitch();
 
+	/** Also write the save slot in the background when travelling through a transition volume */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SaveData")
+	bool bSaveInBackgroundOnTravel;
+
+	/** Character -> stats, shared by SaveGame and the travel handoff */
+	void WriteCharacterStats(struct FCharacterStats& Stats);
+
+	/** Stats -> character, without location and weapon */
+	void ReadCharacterStats(const struct FCharacterStats& Stats);
+
+	/** Get the character moving again after its state was loaded */
+	void ResetStateAfterLoad();
+
 	
 };
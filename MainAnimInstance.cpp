@@ -3,6 +3,7 @@
 #include "MainAnimInstance.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Main.h"
+#include "FirstProjectCosmetics.h"
 
 void UMainAnimInstance::NativeInitializeAnimation()
 {
@@ -27,11 +28,14 @@ void UMainAnimInstance::UpdateAnimationProperties()
 
 	if (Pawn)
 	{
+#if FIRSTPROJECT_WITH_COSMETICS
+		// Only drives the locomotion pose, montages and their notifies don't need it
 		FVector Speed = Pawn->GetVelocity();
 		FVector LateralSpeed = FVector(Speed.X, Speed.Y, 0.f);
 		MovementSpeed = LateralSpeed.Size();
 
 		bIsInAir = Pawn->GetMovementComponent()->IsFalling();	
+#endif
 
 		if (Main == nullptr)
 		{
@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "MainBotController.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Misc/CommandLine.h"
+#include "Main.h"
+#include "Enemy.h"
+#include "Weapon.h"
+#include "LevelTransitionVolume.h"
+
+AMainBotController::AMainBotController()
+{
+	DecisionInterval = 0.5f;
+	SearchRadius = 4000.f;
+	WanderRadius = 2000.f;
+	AttackRange = 200.f;
+	SprintChance = 0.3f;
+	TransitionChance = 0.02f;
+	bCrossLevelTransitions = false;
+
+	Goal = EBotGoal::Wander;
+	GoalLocation = FVector::ZeroVector;
+	DecisionTimer = 0.f;
+}
+
+void AMainBotController::BeginPlay()
+{
+	Super::BeginPlay();
+
+	int32 Seed = GetUniqueID();
+	FParse::Value(FCommandLine::Get(), TEXT("BotSeed="), Seed);
+	Random.Initialize(Seed);
+
+	bCrossLevelTransitions |= FParse::Param(FCommandLine::Get(), TEXT("BotTravel"));
+
+	// Spread the decisions of bots that joined together
+	DecisionTimer = Random.FRandRange(0.f, DecisionInterval);
+}
+
+void AMainBotController::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// The server copy of a bot controller does nothing, the bot's client drives it
+	if (!IsLocalController())
+		return;
+
+	AMain* Main = Cast<AMain>(GetPawn());
+	if (Main == nullptr || Main->MovementStatus == EMovementStatus::EMS_Dead)
+		return;
+
+	DecisionTimer -= DeltaTime;
+	if (DecisionTimer <= 0.f)
+	{
+		DecisionTimer = DecisionInterval;
+		Decide(Main);
+	}
+
+	Steer(Main);
+}
+
+template<typename T, typename FilterType>
+T* AMainBotController::FindClosest(const FVector& From, FilterType Filter) const
+{
+	T* Closest = nullptr;
+	float ClosestDistance = FMath::Square(SearchRadius);
+	for (TActorIterator<T> It(GetWorld()); It; ++It)
+	{
+		float Distance = FVector::DistSquared(From, It->GetActorLocation());
+		if (Distance < ClosestDistance && Filter(*It))
+		{
+			Closest = *It;
+			ClosestDistance = Distance;
+		}
+	}
+	return Closest;
+}
+
+void AMainBotController::Decide(AMain* Main)
+{
+	const FVector Location = Main->GetActorLocation();
+	GoalActor.Reset();
+
+	if (Main->EquippedWeapon == nullptr)
+	{
+		GoalActor = FindClosest<AWeapon>(Location, [](AWeapon* Weapon) { return Weapon->GetWeaponState() == EWeaponState::EMS_Pickup; });
+		Goal = EBotGoal::PickupWeapon;
+	}
+	else
+	{
+		GoalActor = FindClosest<AEnemy>(Location, [](AEnemy* Enemy) { return Enemy->Alive(); });
+		Goal = EBotGoal::AttackEnemy;
+	}
+
+	if (!GoalActor.IsValid() && bCrossLevelTransitions && Random.FRand() < TransitionChance)
+	{
+		GoalActor = FindClosest<ALevelTransitionVolume>(Location, [](ALevelTransitionVolume*) { return true; });
+		Goal = EBotGoal::CrossTransition;
+	}
+
+	if (!GoalActor.IsValid())
+	{
+		Goal = EBotGoal::Wander;
+		float Angle = Random.FRandRange(0.f, 2.f * PI);
+		float Radius = Random.FRandRange(0.f, WanderRadius);
+		GoalLocation = Location + FVector(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, 0.f);
+	}
+
+	if (Random.FRand() < SprintChance)
+	{
+		Main->ShiftKeyDown();
+	}
+	else
+	{
+		Main->ShiftKeyUp();
+	}
+}
+
+void AMainBotController::Steer(AMain* Main)
+{
+	if (GoalActor.IsValid())
+	{
+		GoalLocation = GoalActor->GetActorLocation();
+	}
+
+	FVector ToGoal = GoalLocation - Main->GetActorLocation();
+	ToGoal.Z = 0.f;
+	const float Distance = ToGoal.Size();
+
+	SetControlRotation(FRotator(0.f, ToGoal.Rotation().Yaw, 0.f));
+
+	switch (Goal)
+	{
+		case EBotGoal::PickupWeapon:
+			// Same path as a player's click: predicted locally, then ServerEquip/ServerAttack,
+			// and the weapon overlap sends ServerClaimMeleeHit, so the server sees real player traffic
+			if (Main->ActiveOverlappingItem)
+			{
+				Main->LMBDown();
+				Main->LMBUp();
+				return;
+			}
+		break;
+
+		case EBotGoal::AttackEnemy:
+			if (Distance <= AttackRange)
+			{
+				Main->UpdateCombatTarget();
+				Main->LMBDown();
+				Main->LMBUp();
+				return;
+			}
+		break;
+
+		default:
+			;
+	}
+
+	if (Distance > 50.f)
+	{
+		Main->MoveForward(1.f);
+	}
+}
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MainPlayerController.h"
+#include "Math/RandomStream.h"
+#include "MainBotController.generated.h"
+
+/**
+ * Scripted stand-in for a player, used for load testing a dedicated server.
+ * The server hands it out instead of the normal controller to clients that join with ?Bot:
+ *   FirstProject_20 127.0.0.1?Bot -game -nullrhi -nosound -unattended -BotSeed=N
+ * LaunchBots.bat starts any number of these with distinct seeds.
+ * On the owning client it drives AMain through the same functions the input bindings
+ * call: it walks and sprints, picks up weapons, targets and attacks enemies, and with
+ * -BotTravel it also heads for level transition volumes.
+ */
+UCLASS()
+class FIRSTPROJECT_20_API AMainBotController : public AMainPlayerController
+{
+	GENERATED_BODY()
+
+public:
+	AMainBotController();
+
+	/** Seconds between picking a new goal */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	float DecisionInterval;
+
+	/** How far the bot looks for weapons and enemies */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	float SearchRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	float WanderRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	float AttackRange;
+
+	/** Chance per decision to sprint towards the goal */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	float SprintChance;
+
+	/** Chance per decision to head for a level transition volume, only with bCrossLevelTransitions */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	float TransitionChance;
+
+	/** Crossing a volume travels the whole server, off unless -BotTravel */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	bool bCrossLevelTransitions;
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	enum class EBotGoal : uint8
+	{
+		Wander,
+		PickupWeapon,
+		AttackEnemy,
+		CrossTransition
+	};
+
+	void Decide(class AMain* Main);
+	void Steer(class AMain* Main);
+
+	/** Closest actor of the class within SearchRadius that passes the filter */
+	template<typename T, typename FilterType>
+	T* FindClosest(const FVector& From, FilterType Filter) const;
+
+	EBotGoal Goal;
+
+	TWeakObjectPtr<AActor> GoalActor;
+	FVector GoalLocation;
+
+	float DecisionTimer;
+
+	FRandomStream Random;
+};
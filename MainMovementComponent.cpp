@@ -0,0 +1,221 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "MainMovementComponent.h"
+#include "FirstProject_20.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Corrections"), STAT_MovementCorrections, STATGROUP_FirstProject);
+
+UMainMovementComponent::UMainMovementComponent()
+{
+	bWantsInitializeComponent = true;
+
+	bWantsToSprint = false;
+	bSprinting = false;
+	StaminaCorrectionThreshold = 15.f;
+	CorrectionCount = 0;
+	MainOwner = nullptr;
+}
+
+void UMainMovementComponent::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	MainOwner = Cast<AMain>(GetOwner());
+}
+
+float UMainMovementComponent::GetMaxSpeed() const
+{
+	if (MainOwner && (MovementMode == MOVE_Walking || MovementMode == MOVE_NavWalking))
+	{
+		return bSprinting ? MainOwner->SprintingSpeed : MainOwner->RunnungSpeed;
+	}
+	return Super::GetMaxSpeed();
+}
+
+void UMainMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+
+	if (MainOwner && MainOwner->MovementStatus != EMovementStatus::EMS_Dead)
+	{
+		UpdateStamina(DeltaSeconds);
+	}
+}
+
+void UMainMovementComponent::UpdateStamina(float DeltaSeconds)
+{
+	AMain* Main = MainOwner;
+	const float PreviousStamina = Main->Stamina;
+	const float DeltaStamina = Main->StaminaDrainRate * DeltaSeconds;
+	const bool bMoving = !GetCurrentAcceleration().IsNearlyZero();
+	bool bSprint = false;
+
+	switch (Main->StaminaStatus)
+	{
+		case EStaminaStatus::ESS_Normal:
+			if (bWantsToSprint)
+			{
+				if (Main->Stamina - DeltaStamina <= Main->MinSprintStamina)
+				{
+					Main->SetStaminaStatus(EStaminaStatus::ESS_BelowMinimum);
+				}
+				Main->Stamina -= DeltaStamina;
+				bSprint = bMoving;
+			}
+			else
+			{
+				Main->Stamina = FMath::Min(Main->Stamina + DeltaStamina, Main->MaxStamina);
+			}
+		break;
+
+		case EStaminaStatus::ESS_BelowMinimum:
+			if (bWantsToSprint)
+			{
+				if (Main->Stamina - DeltaStamina <= 0.f)
+				{
+					Main->SetStaminaStatus(EStaminaStatus::ESS_Exhausted);
+					Main->Stamina = 0.f;
+				}
+				else
+				{
+					Main->Stamina -= DeltaStamina;
+					bSprint = bMoving;
+				}
+			}
+			else
+			{
+				if (Main->Stamina + DeltaStamina >= Main->MinSprintStamina)
+				{
+					Main->SetStaminaStatus(EStaminaStatus::ESS_Normal);
+				}
+				Main->Stamina += DeltaStamina;
+			}
+		break;
+
+		case EStaminaStatus::ESS_Exhausted:
+			if (bWantsToSprint)
+			{
+				Main->Stamina = 0.f;
+			}
+			else
+			{
+				Main->SetStaminaStatus(EStaminaStatus::ESS_ExhaustedRecovering);
+				Main->Stamina += DeltaStamina;
+			}
+		break;
+
+		case EStaminaStatus::ESS_ExhaustedRecovering:
+			if (Main->Stamina + DeltaStamina >= Main->MinSprintStamina)
+			{
+				Main->SetStaminaStatus(EStaminaStatus::ESS_Normal);
+			}
+			Main->Stamina += DeltaStamina;
+		break;
+
+		default:
+			;
+	}
+
+	bSprinting = bSprint;
+	Main->SetMovementStatus(bSprint ? EMovementStatus::EMS_Sprinting : EMovementStatus::EMS_Normal);
+
+	if (Main->Stamina != PreviousStamina)
+	{
+		MARK_PROPERTY_DIRTY_FROM_NAME(AMain, Stamina, Main);
+	}
+}
+
+void UMainMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	bWantsToSprint = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+}
+
+FNetworkPredictionData_Client* UMainMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		UMainMovementComponent* MutableThis = const_cast<UMainMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Main(*this);
+	}
+	return ClientPredictionData;
+}
+
+bool UMainMovementComponent::ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientLoc, const FVector& RelativeClientLoc, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode)
+{
+	const bool bError = Super::ServerCheckClientError(ClientTimeStamp, DeltaTime, Accel, ClientLoc, RelativeClientLoc, ClientMovementBase, ClientBaseBoneName, ClientMovementMode);
+	if (bError)
+	{
+		++CorrectionCount;
+		INC_DWORD_STAT(STAT_MovementCorrections);
+		CSV_CUSTOM_STAT(FirstProject, MovementCorrections, 1, ECsvCustomStatOp::Accumulate);
+	}
+	return bError;
+}
+
+void FSavedMove_Main::Clear()
+{
+	Super::Clear();
+
+	bSavedWantsToSprint = false;
+	SavedStamina = 0.f;
+	SavedStaminaStatus = EStaminaStatus::ESS_Normal;
+}
+
+uint8 FSavedMove_Main::GetCompressedFlags() const
+{
+	uint8 Result = Super::GetCompressedFlags();
+	if (bSavedWantsToSprint)
+	{
+		Result |= FLAG_Custom_0;
+	}
+	return Result;
+}
+
+bool FSavedMove_Main::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	const FSavedMove_Main* NewMainMove = static_cast<const FSavedMove_Main*>(NewMove.Get());
+	if (bSavedWantsToSprint != NewMainMove->bSavedWantsToSprint || SavedStaminaStatus != NewMainMove->SavedStaminaStatus)
+	{
+		return false;
+	}
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_Main::SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(Character, InDeltaTime, NewAccel, ClientData);
+
+	// Captured before the move runs, so a replay starts from the same stamina
+	if (UMainMovementComponent* Movement = Cast<UMainMovementComponent>(Character->GetCharacterMovement()))
+	{
+		bSavedWantsToSprint = Movement->bWantsToSprint;
+	}
+	if (AMain* Main = Cast<AMain>(Character))
+	{
+		SavedStamina = Main->Stamina;
+		SavedStaminaStatus = Main->StaminaStatus;
+	}
+}
+
+void FSavedMove_Main::PrepMoveFor(ACharacter* Character)
+{
+	Super::PrepMoveFor(Character);
+
+	if (UMainMovementComponent* Movement = Cast<UMainMovementComponent>(Character->GetCharacterMovement()))
+	{
+		Movement->bWantsToSprint = bSavedWantsToSprint;
+	}
+	if (AMain* Main = Cast<AMain>(Character))
+	{
+		Main->Stamina = SavedStamina;
+		Main->StaminaStatus = SavedStaminaStatus;
+	}
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_Main::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_Main());
+}
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Main.h"
+#include "MainMovementComponent.generated.h"
+
+/**
+ * Character movement for AMain with sprint and stamina inside the simulation.
+ * The sprint key travels to the server as a compressed move flag and stamina is
+ * simulated per move on both sides, so sprinting doesn't get corrected by a server
+ * that never saw the key.
+ */
+UCLASS()
+class FIRSTPROJECT_20_API UMainMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+	friend class FSavedMove_Main;
+
+public:
+	UMainMovementComponent();
+
+	/** Set from input on the owning client, from the move flags on the server */
+	uint8 bWantsToSprint : 1;
+
+	FORCEINLINE void SetWantsToSprint(bool bSprint) { bWantsToSprint = bSprint; }
+	FORCEINLINE bool IsSprinting() const { return bSprinting; }
+
+	/** Owner-only stamina updates within this of the predicted value are ignored */
+	UPROPERTY(EditDefaultsOnly, Category = "Character Movement: Sprint")
+	float StaminaCorrectionThreshold;
+
+	/** Server side movement corrections sent to this character's client */
+	int32 GetCorrectionCount() const { return CorrectionCount; }
+
+	virtual float GetMaxSpeed() const override;
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual class FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+	virtual bool ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientLoc, const FVector& RelativeClientLoc, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode) override;
+
+protected:
+	virtual void InitializeComponent() override;
+
+	/** The stamina state machine AMain used to run in Tick, now once per move */
+	void UpdateStamina(float DeltaSeconds);
+
+	UPROPERTY(Transient)
+	AMain* MainOwner;
+
+	uint8 bSprinting : 1;
+
+	int32 CorrectionCount;
+};
+
+/** Sprint key plus the stamina the move started with, restored before a replay */
+class FSavedMove_Main : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	uint8 bSavedWantsToSprint : 1;
+	float SavedStamina;
+	EStaminaStatus SavedStaminaStatus;
+
+	virtual void Clear() override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	virtual void SetMoveFor(ACharacter* Character, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual void PrepMoveFor(ACharacter* Character) override;
+};
+
+class FNetworkPredictionData_Client_Main : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_Main(const UCharacterMovementComponent& ClientMovement) : Super(ClientMovement) {}
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
@@ -2,11 +2,18 @@
 
 #include "MainPlayerController.h"
 #include "Blueprint/UserWidget.h"
+#include "Main.h"
+#include "InputRecorderComponent.h"
+#include "FirstProjectCosmetics.h"
 
 void AMainPlayerController::BeginPlay()
 {
 	Super::BeginPlay();
 
+#if FIRSTPROJECT_WITH_COSMETICS
+	// Servers and remote controllers on a listen server have no screen to put these on
+	if (!FFirstProjectCosmetics::ShouldCreateWidgets(this)) return;
+
 	if (HUDOverlayAsset)
 	{
 		HUDOverlay = CreateWidget<UUserWidget>(this, HUDOverlayAsset);
@@ -42,6 +49,7 @@ void AMainPlayerController::BeginPlay()
 			PauseMenu->SetVisibility(ESlateVisibility::Hidden);
 		}
 	}
+#endif
 }
 
 void AMainPlayerController::DisplayEnemyHealthBar()
@@ -66,6 +74,7 @@ void AMainPlayerController::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+#if FIRSTPROJECT_WITH_COSMETICS
 	if (EnemyHealthBar)
 	{
 		// Screen coordinates
@@ -78,6 +87,7 @@ void AMainPlayerController::Tick(float DeltaTime)
 		EnemyHealthBar->SetPositionInViewport(PositionViewport);
 		EnemyHealthBar->SetDesiredSizeInViewport(SizeInViewport);
 	}
+#endif
 }
 
 void AMainPlayerController::DisplayPauseMenu_Implementation()
@@ -122,3 +132,37 @@ void AMainPlayerController::TogglePauseMenu()
 	}
 }
 
+void AMainPlayerController::RecordInput(const FString& Name)
+{
+	AMain* Main = Cast<AMain>(GetPawn());
+	if (Main && Main->InputRecorder)
+	{
+		Main->InputRecorder->StartRecording(Name);
+	}
+}
+
+void AMainPlayerController::ReplayInput(const FString& Name)
+{
+	AMain* Main = Cast<AMain>(GetPawn());
+	if (Main && Main->InputRecorder)
+	{
+		Main->InputRecorder->StartReplay(Name);
+	}
+}
+
+void AMainPlayerController::StopInput()
+{
+	AMain* Main = Cast<AMain>(GetPawn());
+	if (Main && Main->InputRecorder)
+	{
+		Main->InputRecorder->Stop();
+	}
+}
+
+void AMainPlayerController::ClientHitCues_Implementation(const TArray<FHitCue>& Cues)
+{
+	if (AHitCueBatcher* Batcher = AHitCueBatcher::Get(this))
+	{
+		Batcher->ReceiveHitCues(Cues);
+	}
+}
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerController.h"
+#include "HitCueBatcher.h"
 #include "MainPlayerController.generated.h"
 
 /**
@@ -56,6 +57,22 @@ public:
 	//UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "HUD")
 	void TogglePauseMenu();
 
+	/** Console: record the player's input to Saved/InputRecordings/<Name>.fpinput */
+	UFUNCTION(Exec)
+	void RecordInput(const FString& Name);
+
+	/** Console: replay a recording made with RecordInput */
+	UFUNCTION(Exec)
+	void ReplayInput(const FString& Name);
+
+	/** Console: stop recording or replaying */
+	UFUNCTION(Exec)
+	void StopInput();
+
+	/** The hit cues near this player from one server frame, see AHitCueBatcher */
+	UFUNCTION(Client, Unreliable)
+	void ClientHitCues(const TArray<FHitCue>& Cues);
+
 
 protected:
 	virtual void BeginPlay() override;
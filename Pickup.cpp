@@ -2,6 +2,7 @@
 #include "Pickup.h"
 #include "Main.h"
 #include "Kismet/GameplayStatics.h"
+#include "FirstProjectCosmetics.h"
 #include "Engine/World.h"
 #include "Sound/SoundCue.h"
 
@@ -28,12 +29,12 @@ void APickup::OnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* O
 
 			if (OverlapParticles)
 			{
-				UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), OverlapParticles, GetActorLocation(), FRotator(0.f), true);
+				FFirstProjectCosmetics::SpawnEmitterAtLocation(this, OverlapParticles, GetActorLocation(), true);
 			}
 
 			if (OverlapSound)
 			{
-				UGameplayStatics::PlaySound2D(this, OverlapSound);
+				FFirstProjectCosmetics::PlaySound2D(this, OverlapSound);
 			}
 
 			
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "RandomStreamSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/GameInstance.h"
+#include "Misc/CommandLine.h"
+
+void URandomStreamSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	int32 Seed = 0;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("Seed="), Seed))
+	{
+		Seed = (int32)(FPlatformTime::Cycles64() & 0x7fffffff);
+	}
+	SetSessionSeed(Seed);
+}
+
+void URandomStreamSubsystem::SetSessionSeed(int32 Seed)
+{
+	SessionSeed = Seed;
+
+	// Each stream gets its own seed so they don't roll in lockstep
+	for (int32 i = 0; i < (int32)ERandomStreamId::ERS_MAX; i++)
+	{
+		Streams[i].Initialize((int32)HashCombine(GetTypeHash(Seed), GetTypeHash(i)));
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("RandomStreamSubsystem: session seed %d"), SessionSeed);
+}
+
+FRandomStream& URandomStreamSubsystem::GetStream(ERandomStreamId Id)
+{
+	check(Id < ERandomStreamId::ERS_MAX);
+	return Streams[(int32)Id];
+}
+
+FRandomStream& URandomStreamSubsystem::Get(const UObject* WorldContextObject, ERandomStreamId Id)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	URandomStreamSubsystem* Subsystem = GameInstance ? GameInstance->GetSubsystem<URandomStreamSubsystem>() : nullptr;
+
+	if (Subsystem)
+	{
+		return Subsystem->GetStream(Id);
+	}
+
+	static FRandomStream Fallback(0);
+	return Fallback;
+}
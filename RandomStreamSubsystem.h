@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Math/RandomStream.h"
+#include "RandomStreamSubsystem.generated.h"
+
+UENUM(BlueprintType)
+enum class ERandomStreamId : uint8
+{
+	ERS_Combat UMETA(DisplayName = "Combat"),
+	ERS_AI UMETA(DisplayName = "AI"),
+	ERS_Spawning UMETA(DisplayName = "Spawning"),
+
+	ERS_MAX UMETA(DisplayName = "DefaultMAX")
+};
+
+/**
+ * One FRandomStream per gameplay subsystem, all derived from a single session seed.
+ * The seed comes from -Seed=N, a recording being replayed or SetSessionSeed; with
+ * the same seed a session rolls the same numbers, and one subsystem drawing more
+ * often doesn't shift the others.
+ */
+UCLASS()
+class FIRSTPROJECT_20_API URandomStreamSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Reseed every stream from a new session seed */
+	UFUNCTION(BlueprintCallable, Category = "Random")
+	void SetSessionSeed(int32 Seed);
+
+	UFUNCTION(BlueprintPure, Category = "Random")
+	int32 GetSessionSeed() const { return SessionSeed; }
+
+	FRandomStream& GetStream(ERandomStreamId Id);
+
+	/** Stream for the game instance of WorldContextObject, or a shared fallback outside a game */
+	static FRandomStream& Get(const UObject* WorldContextObject, ERandomStreamId Id);
+
+protected:
+
+	int32 SessionSeed;
+
+	FRandomStream Streams[(int32)ERandomStreamId::ERS_MAX];
+};
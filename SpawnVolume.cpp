@@ -1,11 +1,17 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "SpawnVolume.h"
+#include "FirstProject_20.h"
+#include "FirstProjectTrace.h"
 #include "Components/BoxComponent.h" 
 #include "Kismet/KismetMathLibrary.h"
 #include "Engine/World.h"
 #include "Enemy.h"
 #include "AIController.h"
+#include "RandomStreamSubsystem.h"
+#include "EnemySquad.h"
+
+DECLARE_CYCLE_STAT(TEXT("SpawnVolume SpawnOurActor"), STAT_SpawnOurActor, STATGROUP_FirstProject);
 
 // Sets default values
 ASpawnVolume::ASpawnVolume()
@@ -14,7 +20,14 @@ ASpawnVolume::ASpawnVolume()
 	PrimaryActorTick.bCanEverTick = true;
 
 	SpawningBox = CreateDefaultSubobject<UBoxComponent>(TEXT("SpawningBox"));
-	
+
+	// Only the server spawns and the spawned pawns replicate themselves,
+	// clients never need the volume
+	bReplicates = false;
+	NetDormancy = DORM_Initial;
+
+	bSpawnIntoSquads = false;
+	SquadSize = 8;
 }
 
 // Called when the game starts or when spawned
@@ -46,13 +59,20 @@ FVector ASpawnVolume::GetSpawnPoint()
 	FVector Extend = SpawningBox->GetScaledBoxExtent();
 	FVector Origin = SpawningBox->GetComponentLocation();
 
-	FVector Point = UKismetMathLibrary::RandomPointInBoundingBox(Origin, Extend);
+	// Same as RandomPointInBoundingBox, drawn from the spawning stream
+	FRandomStream& Stream = URandomStreamSubsystem::Get(this, ERandomStreamId::ERS_Spawning);
+	FVector Point = Origin + FVector(Stream.FRandRange(-Extend.X, Extend.X), Stream.FRandRange(-Extend.Y, Extend.Y), Stream.FRandRange(-Extend.Z, Extend.Z));
 
 	return Point;
 }
 
 void ASpawnVolume::SpawnOurActor_Implementation(UClass* ToSpawn, const FVector& Location)
 {
+	SCOPE_CYCLE_COUNTER(STAT_SpawnOurActor);
+	CSV_SCOPED_TIMING_STAT(FirstProject, SpawnOurActor);
+	// Everything a spawn volume creates is an enemy with its controller, count it there
+	LLM_SCOPE_BYTAG(FirstProject_Enemies);
+
 	if (ToSpawn)
 	{
 		UWorld* World = GetWorld();
@@ -61,8 +81,21 @@ void ASpawnVolume::SpawnOurActor_Implementation(UClass* ToSpawn, const FVector&
 		if (World)
 		{
 			AActor* Actor = World->SpawnActor<AActor>(ToSpawn, Location, FRotator(0.f), SpawnParams);
+			if (Actor)
+			{
+				INC_DWORD_STAT(STAT_Spawns);
+				CSV_CUSTOM_STAT(FirstProject, Spawns, 1, ECsvCustomStatOp::Accumulate);
+				FIRSTPROJECT_TRACE(Spawn, this, Actor);
+			}
 			AEnemy * Enemy = Cast<AEnemy>(Actor);
-			if (Enemy)
+			if (Enemy && bSpawnIntoSquads)
+			{
+				if (AEnemySquad* Squad = GetSquadWithRoom())
+				{
+					Squad->AddMember(Enemy);
+				}
+			}
+			else if (Enemy)
 			{
 				Enemy->SpawnDefaultController();
 
@@ -76,11 +109,26 @@ void ASpawnVolume::SpawnOurActor_Implementation(UClass* ToSpawn, const FVector&
 	}
 }
 
+AEnemySquad* ASpawnVolume::GetSquadWithRoom()
+{
+	AEnemySquad* Squad = CurrentSquad.Get();
+	if (Squad == nullptr || Squad->GetNumMembers() >= SquadSize)
+	{
+		LLM_SCOPE_BYTAG(FirstProject_SpawnVolumes);
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = this;
+		Squad = GetWorld()->SpawnActor<AEnemySquad>(AEnemySquad::StaticClass(), GetActorLocation(), FRotator::ZeroRotator, SpawnParams);
+		CurrentSquad = Squad;
+	}
+	return Squad;
+}
+
 TSubclassOf<AActor> ASpawnVolume::GetSpawnActor()
 {
 	if (SpawnArray.Num() > 0)
 	{
-		int32 Selection = FMath::RandRange(0, SpawnArray.Num() -1);
+		int32 Selection = URandomStreamSubsystem::Get(this, ERandomStreamId::ERS_Spawning).RandRange(0, SpawnArray.Num() -1);
 
 		return SpawnArray[Selection];
 	}
@@ -32,6 +32,16 @@ public:
 
 	TArray<TSubclassOf<AActor>> SpawnArray;
 
+	/** Group spawned enemies under AEnemySquad brains instead of giving each an AI controller */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawning")
+	bool bSpawnIntoSquads;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Spawning", meta = (EditCondition = "bSpawnIntoSquads"))
+	int32 SquadSize;
+
+	/** Squad new enemies join until it's full */
+	TWeakObjectPtr<class AEnemySquad> CurrentSquad;
+
 
 
 protected:
@@ -50,5 +60,7 @@ public:
 
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "Spawning")
 	void SpawnOurActor(UClass* ToSpawn, const FVector& Location);
+
+	class AEnemySquad* GetSquadWithRoom();
 	
 };
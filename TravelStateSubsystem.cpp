@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TravelStateSubsystem.h"
+#include "Kismet/GameplayStatics.h"
+#include "GameFramework/PlayerState.h"
+#include "Weapon.h"
+#include "FirstProject_20.h"
+
+FString UTravelStateSubsystem::GetPlayerKey(const AMain* Main)
+{
+	const APlayerState* PlayerState = Main ? Main->GetPlayerState() : nullptr;
+	if (PlayerState == nullptr)
+		return FString();
+
+	if (PlayerState->GetUniqueId().IsValid())
+		return PlayerState->GetUniqueId()->ToString();
+
+	return PlayerState->GetPlayerName();
+}
+
+void UTravelStateSubsystem::StoreFromCharacter(AMain* Main)
+{
+	if (Main == nullptr || !Main->HasAuthority())
+		return;
+
+	FTravelPlayerState& State = PendingStates.FindOrAdd(GetPlayerKey(Main));
+	Main->WriteCharacterStats(State.CharacterStats);
+
+	State.WeaponClass = Main->EquippedWeapon ? Main->EquippedWeapon->GetClass() : nullptr;
+	State.StaminaStatus = Main->StaminaStatus;
+}
+
+bool UTravelStateSubsystem::ApplyToCharacter(AMain* Main)
+{
+	if (Main == nullptr || !Main->HasAuthority())
+		return false;
+
+	FTravelPlayerState State;
+	if (!PendingStates.RemoveAndCopyValue(GetPlayerKey(Main), State))
+		return false;
+
+	Main->ReadCharacterStats(State.CharacterStats);
+	Main->SetStaminaStatus(State.StaminaStatus);
+
+	// Spawn the weapon class directly, no AItemStorage lookup needed
+	UWorld* World = Main->GetWorld();
+	if (State.WeaponClass && World)
+	{
+		LLM_SCOPE_BYTAG(FirstProject_Weapons);
+
+		AWeapon* WeaponToEquip = World->SpawnActor<AWeapon>(State.WeaponClass);
+		if (WeaponToEquip)
+		{
+			WeaponToEquip->Equip(Main);
+		}
+	}
+
+	return true;
+}
+
+void UTravelStateSubsystem::SaveInBackground(const AMain* Main)
+{
+	const FTravelPlayerState* State = PendingStates.Find(GetPlayerKey(Main));
+	if (State == nullptr || State->CharacterStats.Health <= 0.f)
+		return;
+
+	LLM_SCOPE_BYTAG(FirstProject_SaveData);
+
+	UFirstSaveGame* SaveGameInstance = Cast<UFirstSaveGame>(UGameplayStatics::CreateSaveGameObject(UFirstSaveGame::StaticClass()));
+	if (SaveGameInstance)
+	{
+		SaveGameInstance->CharacterStats = State->CharacterStats;
+		UGameplayStatics::AsyncSaveGameToSlot(SaveGameInstance, SaveGameInstance->PlayerName, SaveGameInstance->UserIndex);
+	}
+}
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "FirstSaveGame.h"
+#include "Main.h"
+#include "TravelStateSubsystem.generated.h"
+
+/** One player's state between levels */
+USTRUCT()
+struct FTravelPlayerState
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FCharacterStats CharacterStats;
+
+	UPROPERTY()
+	TSubclassOf<class AWeapon> WeaponClass;
+
+	UPROPERTY()
+	EStaminaStatus StaminaStatus = EStaminaStatus::ESS_Normal;
+};
+
+/**
+ * Carries the players' state across OpenLevel and ServerTravel in memory, so a level
+ * transition doesn't need a save to disk and a load back from it. Server only, each
+ * player's state is keyed by their unique net id (or name when offline).
+ */
+UCLASS()
+class FIRSTPROJECT_20_API UTravelStateSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Copy the character's state, called right before travelling */
+	void StoreFromCharacter(AMain* Main);
+
+	/** Hand the state stored for this character's player to it, returns false if there is none */
+	bool ApplyToCharacter(AMain* Main);
+
+	/** Write the character's stored state to the save slot without blocking the game thread */
+	void SaveInBackground(const AMain* Main);
+
+	FORCEINLINE bool HasPendingState() const { return PendingStates.Num() > 0; }
+
+	/** Who the state belongs to, stable across travel */
+	static FString GetPlayerKey(const AMain* Main);
+
+protected:
+
+	UPROPERTY()
+	TMap<FString, FTravelPlayerState> PendingStates;
+};
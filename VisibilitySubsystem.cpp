@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "VisibilitySubsystem.h"
+#include "FirstProject_20.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Visibility Tick"), STAT_VisibilityTick, STATGROUP_FirstProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Visibility Traces"), STAT_VisibilityTraces, STATGROUP_FirstProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Visibility Cache Hits"), STAT_VisibilityCacheHits, STATGROUP_FirstProject);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Visibility Queue"), STAT_VisibilityQueue, STATGROUP_FirstProject);
+
+UVisibilitySubsystem::UVisibilitySubsystem()
+{
+	TraceBudget = 32;
+	CacheLifetime = 0.5f;
+	TraceChannel = ECC_Visibility;
+	LastPurgeTime = 0.f;
+}
+
+void UVisibilitySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	TraceDelegate.BindUObject(this, &UVisibilitySubsystem::OnTraceDone);
+}
+
+void UVisibilitySubsystem::Deinitialize()
+{
+	TraceDelegate.Unbind();
+	Cache.Empty();
+	Queue.Empty();
+	InFlight.Empty();
+
+	Super::Deinitialize();
+}
+
+uint64 UVisibilitySubsystem::MakeKey(const AActor* Viewer, const AActor* Target)
+{
+	return ((uint64)Viewer->GetUniqueID() << 32) | (uint64)Target->GetUniqueID();
+}
+
+ELineOfSight UVisibilitySubsystem::GetLineOfSight(const AActor* Viewer, const AActor* Target)
+{
+	if (Viewer == nullptr || Target == nullptr)
+		return ELineOfSight::Blocked;
+
+	const uint64 Key = MakeKey(Viewer, Target);
+	FSightEntry& Entry = Cache.FindOrAdd(Key, FSightEntry{ ELineOfSight::Unknown, -MAX_FLT, false });
+
+	if (GetWorld()->GetTimeSeconds() - Entry.TraceTime <= CacheLifetime)
+	{
+		INC_DWORD_STAT(STAT_VisibilityCacheHits);
+		return Entry.Result;
+	}
+
+	if (!Entry.bQueued)
+	{
+		Entry.bQueued = true;
+		Queue.Add(FSightRequest{ Viewer, Target, Key });
+	}
+	return Entry.Result;
+}
+
+void UVisibilitySubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VisibilityTick);
+
+	UWorld* World = GetWorld();
+	const float Now = World->GetTimeSeconds();
+
+	int32 Issued = 0;
+	int32 Consumed = 0;
+	for (; Consumed < Queue.Num() && Issued < TraceBudget; ++Consumed)
+	{
+		const FSightRequest& Request = Queue[Consumed];
+		const AActor* Viewer = Request.Viewer.Get();
+		const AActor* Target = Request.Target.Get();
+		if (Viewer == nullptr || Target == nullptr)
+		{
+			Cache.Remove(Request.Key);
+			continue;
+		}
+
+		FVector EyeLocation;
+		FRotator EyeRotation;
+		Viewer->GetActorEyesViewPoint(EyeLocation, EyeRotation);
+
+		FCollisionQueryParams Params(SCENE_QUERY_STAT(EnemyLineOfSight), false);
+		Params.AddIgnoredActor(Viewer);
+		Params.AddIgnoredActor(Target);
+
+		const FTraceHandle Handle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, EyeLocation, Target->GetActorLocation(), TraceChannel, Params, FCollisionResponseParams::DefaultResponseParam, &TraceDelegate);
+		InFlight.Add(Handle._Handle, Request.Key);
+		++Issued;
+	}
+	Queue.RemoveAt(0, Consumed, false);
+
+	INC_DWORD_STAT_BY(STAT_VisibilityTraces, Issued);
+	SET_DWORD_STAT(STAT_VisibilityQueue, Queue.Num());
+
+	// Forget pairs nobody has asked about for a while, enemies that died or lost interest
+	if (Now - LastPurgeTime > 1.f)
+	{
+		LastPurgeTime = Now;
+		const float MaxAge = CacheLifetime * 4.f;
+		for (auto It = Cache.CreateIterator(); It; ++It)
+		{
+			if (!It->Value.bQueued && Now - It->Value.TraceTime > MaxAge)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+}
+
+void UVisibilitySubsystem::OnTraceDone(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	uint64 Key;
+	if (!InFlight.RemoveAndCopyValue(Handle._Handle, Key))
+		return;
+
+	FSightEntry* Entry = Cache.Find(Key);
+	if (Entry == nullptr)
+		return;
+
+	const bool bBlocked = Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit;
+	Entry->Result = bBlocked ? ELineOfSight::Blocked : ELineOfSight::Visible;
+	Entry->TraceTime = GetWorld()->GetTimeSeconds();
+	Entry->bQueued = false;
+}
+
+TStatId UVisibilitySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UVisibilitySubsystem, STATGROUP_Tickables);
+}
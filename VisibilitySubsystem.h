@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Engine/EngineTypes.h"
+#include "WorldCollision.h"
+#include "VisibilitySubsystem.generated.h"
+
+enum class ELineOfSight : uint8
+{
+	/** Never traced, the answer is on its way */
+	Unknown,
+	Visible,
+	Blocked
+};
+
+/**
+ * Line of sight between actor pairs, answered from a cache and refreshed with async traces.
+ *
+ * Asking never traces on the spot: a missing or stale pair is queued, and each frame
+ * sends at most TraceBudget of the queue as async line traces, which come back the next
+ * frame. Results are good for CacheLifetime; a stale result is still returned while
+ * its refresh is in flight.
+ */
+UCLASS(Config = Game)
+class FIRSTPROJECT_20_API UVisibilitySubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+
+	UVisibilitySubsystem();
+
+	/** Async traces started per frame */
+	UPROPERTY(Config)
+	int32 TraceBudget;
+
+	UPROPERTY(Config)
+	float CacheLifetime;
+
+	UPROPERTY(Config)
+	TEnumAsByte<ECollisionChannel> TraceChannel;
+
+	/** Can Viewer's eyes see Target. Cheap, safe to call every think */
+	ELineOfSight GetLineOfSight(const AActor* Viewer, const AActor* Target);
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return Queue.Num() > 0 || Cache.Num() > 0; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+protected:
+
+	struct FSightEntry
+	{
+		ELineOfSight Result;
+		float TraceTime;
+		bool bQueued;
+	};
+
+	struct FSightRequest
+	{
+		TWeakObjectPtr<const AActor> Viewer;
+		TWeakObjectPtr<const AActor> Target;
+		uint64 Key;
+	};
+
+	static uint64 MakeKey(const AActor* Viewer, const AActor* Target);
+
+	TMap<uint64, FSightEntry> Cache;
+	TArray<FSightRequest> Queue;
+
+	/** Trace handle to the pair it was started for */
+	TMap<uint64, uint64> InFlight;
+
+	FTraceDelegate TraceDelegate;
+	void OnTraceDone(const FTraceHandle& Handle, FTraceDatum& Datum);
+
+	float LastPurgeTime;
+};
@@ -1,16 +1,23 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Weapon.h"
+#include "FirstProject_20.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Main.h"
 #include "Engine/SkeletalMeshSocket.h" 
 #include "Sound/SoundCue.h"
 #include "Kismet/GameplayStatics.h"
+#include "FirstProjectCosmetics.h"
 #include "Particles/ParticleSystemComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/BoxComponent.h"
 #include "Enemy.h"
+#include "HitRewindSubsystem.h"
+#include "HitCueBatcher.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
 
+DECLARE_CYCLE_STAT(TEXT("Weapon Combat Hit"), STAT_WeaponCombatHit, STATGROUP_FirstProject);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Weapon Hit Calls"), STAT_WeaponHitCalls, STATGROUP_FirstProject);
 
 AWeapon::AWeapon()
 {
@@ -41,6 +48,7 @@ void AWeapon::BeginPlay()
 	CombatCollision->SetCollisionObjectType(ECollisionChannel::ECC_WorldDynamic);
 	CombatCollision->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore); // Basically no overlap,
 	CombatCollision->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Overlap); // Enemy is Pawn, so overlap to pawn only
+	CombatCollision->SetCollisionResponseToChannel(ECC_Enemy, ECollisionResponse::ECR_Overlap); // Enemy capsules have their own channel
 
 }
 
@@ -96,13 +104,16 @@ void AWeapon::Equip(AMain * Char)
 			RightHandSocket->AttachActor(this, Char->GetMesh());
 			bRotate = false;
 
+			// Attachment has to reach the clients, after that it just follows the owner
+			MarkItemStateChanged();
+
 			//Char->GetEquippedWeapon()->Destroy();
 
 			Char->SetEquippedWeapon(this);
 			Char->SetActiveOverlappingItem(nullptr);
 		}
 
-		if (OnEquipSound) UGameplayStatics::PlaySound2D(this, OnEquipSound);
+		if (OnEquipSound) FFirstProjectCosmetics::PlaySound2D(this, OnEquipSound);
 		if (!bWeaponParticles)
 		{
 			IdleParticlesComponent->Deactivate();
@@ -112,32 +123,34 @@ void AWeapon::Equip(AMain * Char)
 
 void AWeapon::CombatOnOverlapBegin(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult & SweepResult)
 {
+	SCOPE_CYCLE_COUNTER(STAT_WeaponCombatHit);
+	CSV_SCOPED_TIMING_STAT(FirstProject, WeaponCombatHit);
+	INC_DWORD_STAT(STAT_WeaponHitCalls);
+
 	if (OtherActor)
 	{
 		AEnemy* Enemy = Cast<AEnemy>(OtherActor);
 
 		if (Enemy)
 		{
-			if (Enemy->HitParticles)
-			{			
-				const USkeletalMeshSocket* WeaponSocket = SkeletalMesh->GetSocketByName("WeaponSocket");
-				
-				if (WeaponSocket)
+			const USkeletalMeshSocket* WeaponSocket = SkeletalMesh->GetSocketByName("WeaponSocket");
+			FVector SocketLocation = WeaponSocket ? WeaponSocket->GetSocketLocation(SkeletalMesh) : GetActorLocation();
+
+			AMain* Wielder = WeaponInstigator ? Cast<AMain>(WeaponInstigator->GetPawn()) : nullptr;
+			if (Wielder && !Wielder->HasAuthority())
+			{
+				// Our own swing on a client, the server rewinds the enemy to what we saw and decides
+				if (Wielder->IsLocallyControlled())
 				{
-					FVector SocketLocation = WeaponSocket->GetSocketLocation(SkeletalMesh);
-					UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), Enemy->HitParticles, SocketLocation , FRotator(0.f), false);
+					AHitCueBatcher::PlayPredictedHitCue(this, WeaponSocket ? Enemy->HitParticles : nullptr, Enemy->HitSound, SocketLocation);
+					Wielder->ServerClaimMeleeHit(Enemy, SocketLocation, UHitRewindSubsystem::GetRewindTime(GetWorld()));
 				}
-				//UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), Enemy->HitParticles, GetActorLocation(), FRotator(0.f), false);
-			}
-			
-			if (Enemy->HitSound)
-			{
-				UGameplayStatics::PlaySound2D(this, Enemy->HitSound);
 			}
-			if (DamageTypeClass)
+			else if (!Wielder || Wielder->IsLocallyControlled())
 			{
-				UGameplayStatics::ApplyDamage(Enemy, Damage, WeaponInstigator, this, DamageTypeClass);
+				ApplyHit(Enemy, WeaponSocket ? SocketLocation : GetActorLocation(), WeaponSocket != nullptr);
 			}
+			// A remote player's swing simulated on the server waits for that player's claim
 		}
 	}
 }
@@ -147,6 +160,18 @@ void AWeapon::CombatOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActo
 
 }
 
+void AWeapon::ApplyHit(AEnemy* Enemy, const FVector& HitLocation, bool bWithParticles)
+{
+	// Everyone sees the hit through the batcher, the owning client already played it
+	EPhysicalSurface Surface = UPhysicalMaterial::DetermineSurfaceType(Enemy->GetMesh()->BodyInstance.GetSimplePhysicalMaterial());
+	AHitCueBatcher::QueueHitCue(this, bWithParticles ? Enemy->HitParticles : nullptr, Enemy->HitSound, HitLocation, Surface);
+
+	if (DamageTypeClass)
+	{
+		UGameplayStatics::ApplyDamage(Enemy, Damage, WeaponInstigator, this, DamageTypeClass);
+	}
+}
+
 void AWeapon::ActivateCollision()
 {
 	CombatCollision->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
@@ -71,7 +71,7 @@ public:
 
 	void Equip(class AMain * Char);
 
-	FORCEINLINE void SetWeaponState(EWeaponState State) { WeaponState = State; }
+	FORCEINLINE void SetWeaponState(EWeaponState State) { WeaponState = State; MarkItemStateChanged(); }
 	FORCEINLINE EWeaponState GetWeaponState() { return WeaponState; }
 
 	UFUNCTION()
@@ -79,6 +79,9 @@ public:
 	UFUNCTION()
 	void CombatOnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
 
+	/** Damage the enemy and queue its hit cue, on the server this is the result of a confirmed hit */
+	void ApplyHit(class AEnemy* Enemy, const FVector& HitLocation, bool bWithParticles = true);
+
 	UFUNCTION(BlueprintCallable)
 	void ActivateCollision();
 